@@ -1,9 +1,9 @@
 #include "bitbase.h"
 
 #include <cassert>
-#include <bitset>
 #include <vector>
 
+#include "bitbase_kpk.h"
 #include "bitboard.h"
 
 namespace Bitbases {
@@ -13,8 +13,7 @@ namespace Bitbases {
         // There are 24 possible pawn squares: files A to D and ranks from 2 to 7
         // Positions with the pawn on files E to H will be mirrored before probing.
         constexpr uint32_t KPKSize{ 24 * 2 * 64 * 64 }; // wpSq * active * wkSq * bkSq
-
-        std::bitset<KPKSize> KPKSet;
+        static_assert(sizeof (KPKBitbase) * 8 == KPKSize, "KPK bitbase size mismatch");
 
         // A KPK bitbase index is an integer in [0, KPKSize] range
         //
@@ -36,6 +35,11 @@ namespace Bitbases {
                  | (((sRank(wpSq) - RANK_2) & 7) << 15);
         }
 
+        bool isWin(uint32_t idx) noexcept {
+            return (KPKBitbase[idx >> 6] >> (idx & 63)) & 1;
+        }
+
+#if !defined(NDEBUG)
         enum Result : uint8_t {
             INVALID = 0,
             UNKNOWN = 1 << 0,
@@ -156,9 +160,13 @@ namespace Bitbases {
                      r & UNKNOWN ? UNKNOWN : Bad;
             return result;
         }
+#endif
     }
 
+    /// initialize() verifies the embedded KPK bitbase against the retrograde analysis.
+    /// The analysis is only run in debug builds, release builds start with the table ready.
     void initialize() {
+#if !defined(NDEBUG)
 
         std::vector<KPKPosition> kpkDB(KPKSize);
         // Initialize kpkDB with known WIN/DRAW positions
@@ -175,21 +183,21 @@ namespace Bitbases {
                        && kpkDB[idx].classify(kpkDB) != UNKNOWN;
             }
         }
-        // Fill the Bitbase from kpkDB
+        // Check the Bitbase against kpkDB
+        uint32_t count{ 0 };
         for (uint32_t idx = 0; idx < KPKSize; ++idx) {
-            if (kpkDB[idx] == WIN) {
-                KPKSet.set(idx);
-            }
+            assert(isWin(idx) == (kpkDB[idx] == WIN));
+            count += isWin(idx);
         }
-
-        assert(KPKSet.count() == 111282);
+        assert(count == 111282);
+#endif
     }
 
     bool probe(bool stngActive, Square skSq, Square wkSq, Square spSq) noexcept {
         // skSq = White King
         // wkSq = Black King
         // spSq = White Pawn
-        return KPKSet[index(stngActive ? WHITE : BLACK, skSq, wkSq, spSq)];
+        return isWin(index(stngActive ? WHITE : BLACK, skSq, wkSq, spSq));
     }
 
 }
@@ -1,9 +1,18 @@
 #include "bitboard.h"
 
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <limits>
 #include <memory>
 #include <sstream>
+#include <string_view>
 #include <vector>
 
+#if defined(USE_SLIDER_SELECT) && defined(USE_BMI2) && !defined(_MSC_VER)
+    #include <cpuid.h>
+#endif
+
 #include "notation.h"
 #include "helper/prng.h"
 
@@ -18,6 +27,10 @@ Bitboard PieceAttacksBB[PIECE_TYPES][SQUARES];
 Magic BMagics[SQUARES];
 Magic RMagics[SQUARES];
 
+#if defined(USE_SLIDER_SELECT)
+SliderType Slider{ SLIDER_MAGIC };
+#endif
+
 #if !defined(USE_POPCNT)
 #include <bitset>
 
@@ -81,26 +94,58 @@ namespace {
     //    16384 +     49152 +     36864 = 102400
     Bitboard RAttacks[0x19000];
 
+#if defined(IS_64BIT)
+    // Magic numbers found by the seeded search (seeds 0x002D8, 0x0284C, 0x0D6E5, 0x08023,
+    // 0x02FF9, 0x03AFC, 0x04105, 0x000FF per rank), kept so startup skips the search
+    constexpr Bitboard BMagicNumbers[SQUARES]{
+        U64(0x40106000A1160020), U64(0x0020010250810120), U64(0x2010010220280081), U64(0x002806004050C040),
+        U64(0x0002021018000000), U64(0x2001112010000400), U64(0x0881010120218080), U64(0x1030820110010500),
+        U64(0x0000120222042400), U64(0x2000020404040044), U64(0x8000480094208000), U64(0x0003422A02000001),
+        U64(0x000A220210100040), U64(0x8004820202226000), U64(0x0018234854100800), U64(0x0100004042101040),
+        U64(0x0004001004082820), U64(0x0010000810010048), U64(0x1014004208081300), U64(0x2080818802044202),
+        U64(0x0040880C00A00100), U64(0x0080400200522010), U64(0x0001000188180B04), U64(0x0080249202020204),
+        U64(0x1004400004100410), U64(0x00013100A0022206), U64(0x2148500001040080), U64(0x4241080011004300),
+        U64(0x4020848004002000), U64(0x10101380D1004100), U64(0x0008004422020284), U64(0x01010A1041008080),
+        U64(0x0808080400082121), U64(0x0808080400082121), U64(0x0091128200100C00), U64(0x0202200802010104),
+        U64(0x8C0A020200440085), U64(0x01A0008080B10040), U64(0x0889520080122800), U64(0x100902022202010A),
+        U64(0x04081A0816002000), U64(0x0000681208005000), U64(0x8170840041008802), U64(0x0A00004200810805),
+        U64(0x0830404408210100), U64(0x2602208106006102), U64(0x1048300680802628), U64(0x2602208106006102),
+        U64(0x0602010120110040), U64(0x0941010801043000), U64(0x000040440A210428), U64(0x0008240020880021),
+        U64(0x0400002012048200), U64(0x00AC102001210220), U64(0x0220021002009900), U64(0x84440C080A013080),
+        U64(0x0001008044200440), U64(0x0004C04410841000), U64(0x2000500104011130), U64(0x1A0C010011C20229),
+        U64(0x0044800112202200), U64(0x0434804908100424), U64(0x0300404822C08200), U64(0x48081010008A2A80)
+    };
+    constexpr Bitboard RMagicNumbers[SQUARES]{
+        U64(0x0A80004000801220), U64(0x8040004010002008), U64(0x2080200010008008), U64(0x1100100008210004),
+        U64(0xC200209084020008), U64(0x2100010004000208), U64(0x0400081000822421), U64(0x0200010422048844),
+        U64(0x0800800080400024), U64(0x0001402000401000), U64(0x3000801000802001), U64(0x4400800800100083),
+        U64(0x0904802402480080), U64(0x4040800400020080), U64(0x0018808042000100), U64(0x4040800080004100),
+        U64(0x0040048001458024), U64(0x00A0004000205000), U64(0x3100808010002000), U64(0x4825010010000820),
+        U64(0x5004808008000401), U64(0x2024818004000A00), U64(0x0005808002000100), U64(0x2100060004806104),
+        U64(0x0080400880008421), U64(0x4062220600410280), U64(0x010A004A00108022), U64(0x0000100080080080),
+        U64(0x0021000500080010), U64(0x0044000202001008), U64(0x0000100400080102), U64(0xC020128200040545),
+        U64(0x0080002000400040), U64(0x0000804000802004), U64(0x0000120022004080), U64(0x010A386103001001),
+        U64(0x9010080080800400), U64(0x8440020080800400), U64(0x0004228824001001), U64(0x000000490A000084),
+        U64(0x0080002000504000), U64(0x200020005000C000), U64(0x0012088020420010), U64(0x0010010080080800),
+        U64(0x0085001008010004), U64(0x0002000204008080), U64(0x0040413002040008), U64(0x0000304081020004),
+        U64(0x0080204000800080), U64(0x3008804000290100), U64(0x1010100080200080), U64(0x2008100208028080),
+        U64(0x5000850800910100), U64(0x8402019004680200), U64(0x0120911028020400), U64(0x0000008044010200),
+        U64(0x0020850200244012), U64(0x0020850200244012), U64(0x0000102001040841), U64(0x140900040A100021),
+        U64(0x000200282410A102), U64(0x000200282410A102), U64(0x000200282410A102), U64(0x4048240043802106)
+    };
+#endif
+
     /// Initialize all bishop and rook attacks at startup.
     /// Magic bitboards are used to look up attacks of sliding pieces.
     /// In particular, here we use the so called "fancy" approach.
+    /// With PEXT slider the attacks are indexed directly by the extracted occupancy bits.
     template<PieceType PT>
     void initializeMagic(Bitboard attacks[], Magic magics[]) noexcept {
 
-#if !defined(USE_BMI2)
         constexpr uint16_t MaxIndex{ 0x1000 };
         Bitboard occupancy[MaxIndex];
         Bitboard reference[MaxIndex];
 
-        constexpr uint32_t Seeds[RANKS]{
-    #if defined(IS_64BIT)
-        0x002D8, 0x0284C, 0x0D6E5, 0x08023, 0x02FF9, 0x03AFC, 0x04105, 0x000FF
-    #else
-        0x02311, 0x0AE10, 0x0D447, 0x09856, 0x01663, 0x173E5, 0x199D0, 0x0427C
-    #endif
-        };
-#endif
-
         uint16_t size{ 0 };
         //uint16_t cnt{ 0 };
         for (Square s = SQ_A1; s <= SQ_H8; ++s) {
@@ -125,25 +170,23 @@ namespace {
             // new Bitboard[1 << popCount(magic.mask)];
             magic.attacks = (s == SQ_A1) ? attacks : magics[s - 1].attacks + size;
 
-#if !defined(USE_BMI2)
     #if defined(IS_64BIT)
             magic.shift = 64 - popCount(magic.mask);
     #else
             magic.shift = 32 - popCount(magic.mask);
     #endif
-#endif
 
             size = 0;
             // Use Carry-Rippler trick to enumerate all subsets of magic.mask
             // Store the corresponding slide attack bitboard in reference[].
             Bitboard occ{ 0 };
             do {
-
-#if !defined(USE_BMI2)
                 occupancy[size] = occ;
                 reference[size] = slideAttacks<PT>(s, occ);
-#else
-                magic.attacks[PEXT(occ, magic.mask)] = slideAttacks<PT>(s, occ);
+#if defined(USE_BMI2)
+                if (Slider == SLIDER_PEXT) {
+                    magic.attacks[PEXT(occ, magic.mask)] = reference[size];
+                }
 #endif
                 ++size;
                 occ = (occ - magic.mask) & magic.mask;
@@ -151,7 +194,32 @@ namespace {
 
             assert(size == (1 << popCount(magic.mask)));
 
-#if !defined(USE_BMI2)
+            if (Slider == SLIDER_PEXT) {
+                continue;
+            }
+
+    #if defined(IS_64BIT)
+            magic.magic = PT == BSHP ? BMagicNumbers[s] : RMagicNumbers[s];
+        #if !defined(NDEBUG)
+            // A good magic must map every possible occupancy to an index that
+            // looks up the correct slide attack, debug builds verify the built-in ones.
+            std::vector<bool> epoch(size, false);
+        #endif
+            for (uint16_t i = 0; i < size; ++i) {
+                uint16_t const idx{ magic.index(occupancy[i]) };
+                assert(idx < size);
+        #if !defined(NDEBUG)
+                assert(!epoch[idx]
+                    || magic.attacks[idx] == reference[i]);
+                epoch[idx] = true;
+        #endif
+                magic.attacks[idx] = reference[i];
+            }
+    #else
+            constexpr uint32_t Seeds[RANKS]{
+                0x02311, 0x0AE10, 0x0D447, 0x09856, 0x01663, 0x173E5, 0x199D0, 0x0427C
+            };
+
             PRNG prng(Seeds[sRank(s)]);
             // Find a magic for square picking up an (almost) random number
             // until found the one that passes the verification test.
@@ -183,9 +251,45 @@ namespace {
                     }
                 }
             }
-#endif
+    #endif
+        }
+    }
+
+#if defined(USE_SLIDER_SELECT) && defined(USE_BMI2)
+    /// slowPEXT() checks whether PEXT is microcoded (AMD before Zen3), so slower than the magic multiply
+    bool slowPEXT() noexcept {
+        uint32_t regs[4]{ 0, 0, 0, 0 }; // eax, ebx, ecx, edx
+    #if defined(_MSC_VER)
+        __cpuid(reinterpret_cast<int32_t*>(regs), 0);
+    #else
+        __get_cpuid(0, &regs[0], &regs[1], &regs[2], &regs[3]);
+    #endif
+        // Vendor "AuthenticAMD" is in ebx, edx, ecx
+        bool const amd{ regs[1] == 0x68747541
+                     && regs[3] == 0x69746E65
+                     && regs[2] == 0x444D4163 };
+        if (!amd) {
+            return false;
+        }
+    #if defined(_MSC_VER)
+        __cpuid(reinterpret_cast<int32_t*>(regs), 1);
+    #else
+        __get_cpuid(1, &regs[0], &regs[1], &regs[2], &regs[3]);
+    #endif
+        uint32_t family{ (regs[0] >> 8) & 0xF };
+        if (family == 0xF) {
+            family += (regs[0] >> 20) & 0xFF;
         }
+        // Zen3 is family 0x19
+        return family < 0x19;
     }
+#endif
+
+    std::string_view sliderName(SliderType st) noexcept {
+        return st == SLIDER_PEXT  ? "PEXT" :
+               st == SLIDER_KOGGE ? "Kogge" : "Magic";
+    }
+
 }
 
 namespace Bitboards {
@@ -209,8 +313,7 @@ namespace Bitboards {
 #endif
 
         // Initialize Magic Table
-        initializeMagic<BSHP>(BAttacks, BMagics);
-        initializeMagic<ROOK>(RAttacks, RMagics);
+        initializeSlider(autoSlider());
 
         // Pawn and Pieces Attack Table
         for (Square s = SQ_A1; s <= SQ_H8; ++s) {
@@ -249,6 +352,84 @@ namespace Bitboards {
 
     }
 
+    /// autoSlider() returns the default slider for the host CPU
+    SliderType autoSlider() noexcept {
+#if !defined(USE_SLIDER_SELECT)
+        return Slider;
+#elif defined(USE_BMI2)
+        return slowPEXT() ? SLIDER_MAGIC : SLIDER_PEXT;
+#else
+        return SLIDER_MAGIC;
+#endif
+    }
+
+    /// initializeSlider() selects the slider and initializes its attacks tables.
+    /// Must not be called while searching.
+    void initializeSlider([[maybe_unused]] SliderType st) noexcept {
+#if defined(USE_SLIDER_SELECT)
+    #if !defined(USE_BMI2)
+        if (st == SLIDER_PEXT) {
+            st = SLIDER_MAGIC;
+        }
+    #endif
+        Slider = st;
+#else
+        assert(st == Slider);
+#endif
+        // Kogge-Stone needs no table but keep the magic ones valid
+        initializeMagic<BSHP>(BAttacks, BMagics);
+        initializeMagic<ROOK>(RAttacks, RMagics);
+    }
+
+    /// benchSlider() is a micro-benchmark of the sliders available, to pick the best one for the host.
+    /// Looks up the bishop and rook attacks for all squares on the given number of random occupancies.
+    void benchSlider(uint32_t count) noexcept {
+        constexpr uint16_t OccCount{ 0x400 };
+        PRNG prng(0x1FD3E2A);
+        std::vector<Bitboard> occs(OccCount);
+        for (auto &occ : occs) {
+            occ = prng.rand<Bitboard>() & prng.rand<Bitboard>();
+        }
+
+        auto const selected{ Slider };
+        std::vector<SliderType> sliders{ Slider };
+#if defined(USE_SLIDER_SELECT)
+        sliders = { SLIDER_MAGIC, SLIDER_KOGGE };
+    #if defined(USE_BMI2)
+        sliders.push_back(SLIDER_PEXT);
+    #endif
+#endif
+
+        auto best{ selected };
+        int64_t bestElapsed{ std::numeric_limits<int64_t>::max() };
+        for (auto const st : sliders) {
+            initializeSlider(st);
+
+            Bitboard checksum{ 0 };
+            auto const start{ std::chrono::steady_clock::now() };
+            for (uint32_t i = 0; i < count; ++i) {
+                Bitboard const occ{ occs[i % OccCount] };
+                for (Square s = SQ_A1; s <= SQ_H8; ++s) {
+                    checksum ^= attacksBB<BSHP>(s, occ)
+                              ^ attacksBB<ROOK>(s, occ);
+                }
+            }
+            auto const elapsed{ std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count() };
+
+            if (bestElapsed > elapsed) {
+                bestElapsed = elapsed;
+                best = st;
+            }
+            std::cout << std::left << std::setw(6) << sliderName(st)
+                      << " ps/lookup: " << std::right << std::setw(6) << elapsed * 1000 / (std::max(count, 1U) * SQUARES * 2)
+                      << " checksum: " << std::hex << std::uppercase << std::setfill('0') << std::setw(16) << checksum
+                      << std::dec << std::nouppercase << std::setfill(' ') << '\n';
+        }
+        std::cout << "Best slider: " << sliderName(best) << std::endl;
+
+        initializeSlider(selected);
+    }
+
 #if !defined(NDEBUG)
     /// Returns an ASCII representation of a bitboard to print on console output
     /// Bitboard in an easily readable format. This is sometimes useful for debugging.
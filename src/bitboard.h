@@ -6,6 +6,43 @@
 
 #include "type.h"
 
+/// SliderType is the backend used to look up the attacks of the sliding pieces
+///  - Magic  "Fancy" magic bitboards, multiply & shift indexed tables
+///  - PEXT   BMI2 parallel bits extract indexed tables (microcoded and slow on AMD Zen1/Zen2)
+///  - Kogge  Kogge-Stone occluded fills, computed without any table
+/// It is fixed at build time with -DUSE_SLIDER_MAGIC/-DUSE_SLIDER_PEXT/-DUSE_SLIDER_KOGGE,
+/// With -DUSE_SLIDER_SELECT it is selectable at run time ("Slider Attacks" option), at the cost of a branch per look up.
+/// By default BMI2 builds select at run time, to avoid PEXT where it is slow, and other builds use Magic.
+enum SliderType : uint8_t {
+    SLIDER_MAGIC,
+    SLIDER_PEXT,
+    SLIDER_KOGGE,
+};
+
+#if !defined(USE_SLIDER_SELECT) \
+ && !defined(USE_SLIDER_MAGIC) \
+ && !defined(USE_SLIDER_PEXT) \
+ && !defined(USE_SLIDER_KOGGE)
+    #if defined(USE_BMI2)
+        #define USE_SLIDER_SELECT
+    #else
+        #define USE_SLIDER_MAGIC
+    #endif
+#endif
+
+#if defined(USE_SLIDER_SELECT)
+    extern SliderType Slider;
+#elif defined(USE_SLIDER_MAGIC)
+    constexpr SliderType Slider{ SLIDER_MAGIC };
+#elif defined(USE_SLIDER_PEXT)
+    #if !defined(USE_BMI2)
+        #error "PEXT slider requires USE_BMI2"
+    #endif
+    constexpr SliderType Slider{ SLIDER_PEXT };
+#elif defined(USE_SLIDER_KOGGE)
+    constexpr SliderType Slider{ SLIDER_KOGGE };
+#endif
+
 // Magic holds all magic relevant data for a single square
 struct Magic {
 
@@ -13,8 +50,11 @@ struct Magic {
     uint16_t index(Bitboard occ) const noexcept {
 
     #if defined(USE_BMI2)
-        return uint16_t( PEXT(occ, mask) );
-    #elif defined(IS_64BIT)
+        if (Slider == SLIDER_PEXT) {
+            return uint16_t( PEXT(occ, mask) );
+        }
+    #endif
+    #if defined(IS_64BIT)
         return uint16_t( ((occ & mask) * magic) >> shift );
     #else
         return uint16_t( (uint32_t((uint32_t(occ >> 0x00) & uint32_t(mask >> 0x00)) * uint32_t(magic >> 0x00))
@@ -29,12 +69,8 @@ struct Magic {
 
     Bitboard *attacks;
     Bitboard  mask;
-
-#if !defined(USE_BMI2)
     Bitboard  magic;
     uint8_t   shift;
-#endif
-
 };
 
 constexpr Bitboard SquareBB[SQUARES]{
@@ -250,6 +286,48 @@ inline Bitboard attacksBB(PieceType pt, Square s) noexcept {
     return PieceAttacksBB[pt][s];
 }
 
+namespace KoggeStone {
+
+    /// shift() shifts the bitboard in the direction, clipping the squares wrapped around the board edge
+    template<Direction D, int32_t N = 1>
+    constexpr Bitboard shift(Bitboard bb) noexcept {
+        constexpr Bitboard Clip{
+            D == EAST || D == NORTH_EAST || D == SOUTH_EAST ? ~fileBB(FILE_A) :
+            D == WEST || D == NORTH_WEST || D == SOUTH_WEST ? ~fileBB(FILE_H) : ~Bitboard(0) };
+        // Clip each step of the N steps, for the multi-step shift clip is cumulative on the propagator
+        return (D > 0 ? bb << (D * N) : bb >> (-D * N)) & Clip;
+    }
+
+    /// fill() returns the attacks of the sliders in the direction,
+    /// propagating through the empty squares with parallel prefix (Kogge-Stone) occluded fill.
+    template<Direction D>
+    constexpr Bitboard fill(Bitboard sliders, Bitboard empties) noexcept {
+        empties &= shift<D>(~Bitboard(0));
+        sliders |= empties & shift<D, 1>(sliders);
+        empties &= shift<D, 1>(empties);
+        sliders |= empties & shift<D, 2>(sliders);
+        empties &= shift<D, 2>(empties);
+        sliders |= empties & shift<D, 4>(sliders);
+        return shift<D>(sliders);
+    }
+
+    template<PieceType PT>
+    constexpr Bitboard attacksBB(Square s, Bitboard occ) noexcept {
+        static_assert(PT == BSHP || PT == ROOK, "PT incorrect");
+        Bitboard const sliders{ squareBB(s) };
+        Bitboard const empties{ ~occ };
+        return PT == BSHP ?
+                fill<NORTH_EAST>(sliders, empties)
+              | fill<NORTH_WEST>(sliders, empties)
+              | fill<SOUTH_EAST>(sliders, empties)
+              | fill<SOUTH_WEST>(sliders, empties) :
+                fill<NORTH>(sliders, empties)
+              | fill<SOUTH>(sliders, empties)
+              | fill<EAST >(sliders, empties)
+              | fill<WEST >(sliders, empties);
+    }
+}
+
 /// attacksBB() returns attacks by piece-type from the square on occupancy
 template<PieceType> Bitboard attacksBB(Square, Bitboard) noexcept;
 
@@ -257,10 +335,14 @@ template<> inline Bitboard attacksBB<NIHT>(Square s, Bitboard) noexcept {
     return attacksBB(NIHT, s);
 }
 template<> inline Bitboard attacksBB<BSHP>(Square s, Bitboard occ) noexcept {
-    return BMagics[s].attacksBB(occ);
+    return Slider == SLIDER_KOGGE ?
+            KoggeStone::attacksBB<BSHP>(s, occ) :
+            BMagics[s].attacksBB(occ);
 }
 template<> inline Bitboard attacksBB<ROOK>(Square s, Bitboard occ) noexcept {
-    return RMagics[s].attacksBB(occ);
+    return Slider == SLIDER_KOGGE ?
+            KoggeStone::attacksBB<ROOK>(s, occ) :
+            RMagics[s].attacksBB(occ);
 }
 template<> inline Bitboard attacksBB<QUEN>(Square s, Bitboard occ) noexcept {
     return attacksBB<BSHP>(s, occ)
@@ -386,6 +468,10 @@ namespace Bitboards {
 
     extern void initialize() noexcept;
 
+    extern SliderType autoSlider() noexcept;
+    extern void initializeSlider(SliderType) noexcept;
+    extern void benchSlider(uint32_t) noexcept;
+
 #if !defined(NDEBUG)
     extern std::string toString(Bitboard) noexcept;
 #endif
@@ -1,66 +1,96 @@
 #include "cuckoo.h"
 
-#include "bitboard.h"
+#include <array>
 
 namespace Cuckoos {
 
-    Cuckoo CuckooTable[CuckooSize];
+    namespace {
 
-    // Hash function for indexing the Cuckoo table
-    template<uint8_t F>
-    constexpr uint16_t hash(Key key) {
-        //assert(0 <= F && F <= 3);
-        return (key >> (0x10 * F)) & (CuckooSize - 1);
-    }
-
-    constexpr uint16_t nextHash(Key key, uint16_t h) noexcept {
-        return hash<0>(key) == h ?
-                hash<1>(key) : hash<0>(key);
-    }
+        // Hash function for indexing the Cuckoo table
+        template<uint8_t F>
+        constexpr uint16_t hash(Key key) {
+            //assert(0 <= F && F <= 3);
+            return (key >> (0x10 * F)) & (CuckooSize - 1);
+        }
 
-    void place(Cuckoo &cuckoo) noexcept {
+        constexpr uint16_t nextHash(Key key, uint16_t h) noexcept {
+            return hash<0>(key) == h ?
+                    hash<1>(key) : hash<0>(key);
+        }
 
-        uint16_t h{ hash<0>(cuckoo.key()) };
-        while (true) { // max 20 iteration
+        /// reachable() checks if the piece type can move between the squares on an empty board.
+        constexpr bool reachable(PieceType pt, Square s1, Square s2) noexcept {
+            int32_t const df{ int32_t(sFile(s1)) - int32_t(sFile(s2)) };
+            int32_t const dr{ int32_t(sRank(s1)) - int32_t(sRank(s2)) };
 
-            std::swap(CuckooTable[h], cuckoo);
-            // Arrived at empty slot ?
-            if (cuckoo.empty()) {
-                return;
+            switch (pt) {
+            case NIHT: return df * df + dr * dr == 5;
+            case BSHP: return df * df == dr * dr;
+            case ROOK: return df == 0 || dr == 0;
+            case QUEN: return df * df == dr * dr || df == 0 || dr == 0;
+            case KING: return df * df <= 1 && dr * dr <= 1;
+            default:   return false;
             }
-            // Push victim to alternative slot
-            h = nextHash(cuckoo.key(), h);
         }
-    }
 
-    bool lookup(Key key, Cuckoo &cuckoo) noexcept {
-        return ((cuckoo = CuckooTable[hash<0>(key)]).key() == key)
-            || ((cuckoo = CuckooTable[hash<1>(key)]).key() == key);
-    }
+        /// generate() builds the Cuckoo table with Zobrist hashes of valid reversible moves,
+        /// and the moves themselves. Done at compile time as the keys are constexpr.
+        constexpr std::array<Cuckoo, CuckooSize> generate() noexcept {
+            std::array<Cuckoo, CuckooSize> table{};
 
-    void initialize() {
+            for (Piece const p : Pieces) {
+                // Pawn moves are not reversible
+                if (pType(p) == PAWN) {
+                    continue;
+                }
 
-        std::vector<Cuckoo> cuckoos;
-        for (Piece p : Pieces) {
-            // Pawn moves are not reversible
-            if (pType(p) == PAWN) {
-                continue;
-            }
+                for (int8_t s1 = SQ_A1; s1 <= SQ_H8 + WEST; ++s1) {
+                    for (int8_t s2 = s1 + EAST; s2 <= SQ_H8; ++s2) {
+                        if (!reachable(pType(p), Square(s1), Square(s2))) {
+                            continue;
+                        }
 
-            for (Square s1 = SQ_A1; s1 <= SQ_H8 + WEST; ++s1) {
-                for (Square s2 = s1 + EAST; s2 <= SQ_H8; ++s2) {
-                    if (contains(attacksBB(pType(p), s1, 0), s2)) {
-                        cuckoos.emplace_back(p, s1, s2);
+                        Cuckoo cuckoo{ p, Square(s1), Square(s2) };
+                        uint16_t h{ hash<0>(cuckoo.key()) };
+                        while (true) { // max 20 iteration
+                            Cuckoo const victim{ table[h] };
+                            table[h] = cuckoo;
+                            cuckoo = victim;
+                            // Arrived at empty slot ?
+                            if (cuckoo.empty()) {
+                                break;
+                            }
+                            // Push victim to alternative slot
+                            h = nextHash(cuckoo.key(), h);
+                        }
                     }
                 }
             }
+            return table;
         }
-        assert(cuckoos.size() == 3668); // 2*(168+280+448+728+210) = 7336 / 2
 
-        // Prepare the Cuckoo table
-        std::fill_n(CuckooTable, CuckooSize, Cuckoo{ NO_PIECE, SQ_NONE, SQ_NONE });
-        for (auto cuckoo : cuckoos) {
-            place(cuckoo);
+        // Cuckoo tables with Zobrist hashes of valid reversible moves, and the moves themselves.
+        // generate() takes a few million evaluation steps, over the default constexpr limits
+        // of clang (-fconstexpr-steps) and MSVC (/constexpr:steps), so those build it at start-up.
+#if defined(__GNUC__) && !defined(__clang__) && !defined(__INTEL_COMPILER)
+        constexpr std::array<Cuckoo, CuckooSize> CuckooTable{ generate() };
+
+        constexpr uint16_t occupied(std::array<Cuckoo, CuckooSize> const &table) noexcept {
+            uint16_t count{ 0 };
+            for (auto const &cuckoo : table) {
+                count += !cuckoo.empty();
+            }
+            return count;
         }
+        // 2*(168+280+448+728+210) = 7336 / 2
+        static_assert(occupied(CuckooTable) == 3668, "Cuckoo table corrupted");
+#else
+        std::array<Cuckoo, CuckooSize> const CuckooTable{ generate() };
+#endif
+    }
+
+    bool lookup(Key key, Cuckoo &cuckoo) noexcept {
+        return ((cuckoo = CuckooTable[hash<0>(key)]).key() == key)
+            || ((cuckoo = CuckooTable[hash<1>(key)]).key() == key);
     }
 }
@@ -0,0 +1,204 @@
+#include "don.h"
+
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "engine.h"
+#include "evaluator.h"
+#include "notation.h"
+#include "position.h"
+#include "uci.h"
+#include "helper/commandline.h"
+#include "helper/container.h"
+
+/// DONEngine is an engine with its own position, and the callbacks of the caller.
+struct DONEngine {
+
+    Engine       engine;
+    Position     pos;
+    StateListPtr states;
+
+    DONInfoCallback     infoCallback;
+    DONBestMoveCallback bestMoveCallback;
+    DONMessageCallback  messageCallback;
+    void               *userData;
+};
+
+namespace {
+
+    std::once_flag InitializeFlag;
+
+    void onInfo(DONEngine const *de, SearchInfo const &si) {
+        if (de->infoCallback == nullptr) {
+            return;
+        }
+
+        std::vector<std::string> moves;
+        std::vector<char const*> pv;
+        moves.reserve(si.pv.size());
+        pv.reserve(si.pv.size());
+        for (auto const m : si.pv) {
+            moves.push_back(moveToCAN(m));
+            pv.push_back(moves.back().c_str());
+        }
+
+        DONInfo info;
+        info.depth    = si.depth;
+        info.selDepth = si.selDepth;
+        info.multiPV  = si.multiPV;
+        info.mate     = std::abs(si.value) >= +VALUE_MATE_1_MAX_PLY;
+        info.score    = !info.mate ?
+                            int32_t(toCP(si.value)) :
+                            (si.value > 0 ? +VALUE_MATE - si.value + 1 : -VALUE_MATE - si.value + 0) / 2;
+        info.bound    = si.bound == BOUND_LOWER ? DON_BOUND_LOWER :
+                        si.bound == BOUND_UPPER ? DON_BOUND_UPPER : DON_BOUND_EXACT;
+        info.wdl[0]   = si.wdl[0];
+        info.wdl[1]   = si.wdl[1];
+        info.wdl[2]   = si.wdl[2];
+        info.nodes    = si.nodes;
+        info.nps      = si.time != 0 ? si.nodes * 1000 / si.time : 0;
+        info.tbHits   = si.tbHits;
+        info.time     = si.time;
+        info.hashFull = si.hashFull;
+        info.pvLength = int32_t(pv.size());
+        info.pv       = pv.data();
+        de->infoCallback(de->userData, &info);
+    }
+
+    void onMessage(DONEngine const *de, std::string_view msg) {
+        if (de->messageCallback == nullptr) {
+            return;
+        }
+        std::string const message{ msg };
+        de->messageCallback(de->userData, message.c_str());
+    }
+
+    void onBestMove(DONEngine const *de, Move bm, Move pm) {
+        if (de->bestMoveCallback == nullptr) {
+            return;
+        }
+        auto const bestMove{ moveToCAN(bm) };
+        auto const ponderMove{ pm != MOVE_NONE ? moveToCAN(pm) : std::string{} };
+        de->bestMoveCallback(de->userData, bestMove.c_str(), ponderMove.c_str());
+    }
+}
+
+DONEngine* donCreate(void) {
+    std::call_once(InitializeFlag, []() {
+        CommandLine::initialize("");
+        Engine::initialize();
+    });
+
+    auto *de{ new DONEngine{} };
+
+    EngineScope engineScope{ &de->engine };
+    de->engine.onInfo     = [de](SearchInfo const &si) { onInfo(de, si); };
+    de->engine.onBestMove = [de](Move bm, Move pm) { onBestMove(de, bm, pm); };
+    de->engine.onMessage  = [de](std::string_view msg) { onMessage(de, msg); };
+
+    de->states.reset(new StateList{ 1 });
+    de->pos.setup(UCI::StartFEN, de->states->back(), Threadpool().mainThread());
+    return de;
+}
+
+void donDestroy(DONEngine *de) {
+    delete de;
+}
+
+void donSetCallbacks(DONEngine *de, DONInfoCallback infoCallback, DONBestMoveCallback bestMoveCallback, void *userData) {
+    EngineScope engineScope{ &de->engine };
+    Threadpool().stopThinking();
+
+    de->infoCallback     = infoCallback;
+    de->bestMoveCallback = bestMoveCallback;
+    de->userData         = userData;
+}
+
+void donSetMessageCallback(DONEngine *de, DONMessageCallback messageCallback) {
+    EngineScope engineScope{ &de->engine };
+    Threadpool().stopThinking();
+
+    de->messageCallback = messageCallback;
+}
+
+bool donSetOption(DONEngine *de, char const *name, char const *value) {
+    EngineScope engineScope{ &de->engine };
+
+    if (!contains(Options(), name)
+     || Options()[name].locked()) {
+        return false;
+    }
+    Options()[name] = std::string_view(value);
+    // Threads may have been recreated
+    if (de->pos.thread() != Threadpool().mainThread()) {
+        de->pos.thread(Threadpool().mainThread());
+    }
+    return true;
+}
+
+bool donSetPosition(DONEngine *de, char const *fen, char const *const *moves, int32_t moveCount) {
+    EngineScope engineScope{ &de->engine };
+
+    de->states.reset(new StateList{ 1 });
+    de->pos.setup(fen != nullptr ? fen : UCI::StartFEN, de->states->back(), Threadpool().mainThread());
+
+    for (int32_t i = 0; i < moveCount; ++i) {
+        auto const m{ moveOfCAN(moves[i], de->pos) };
+        if (m == MOVE_NONE) {
+            return false;
+        }
+        de->states->emplace_back();
+        de->pos.doMove(m, de->states->back());
+    }
+    return true;
+}
+
+bool donGo(DONEngine *de, DONLimits const *limits) {
+    EngineScope engineScope{ &de->engine };
+    Threadpool().stopThinking();
+    // No search without the network
+    if (!Evaluator::NNUE::verify()) {
+        return false;
+    }
+    Threadpool().ponder = limits->ponder;
+
+    TimeMgr().startTime = now(); // As early as possible!
+    Limits().clear();
+
+    Limits().clock[WHITE].time = limits->time[WHITE];
+    Limits().clock[BLACK].time = limits->time[BLACK];
+    Limits().clock[WHITE].inc  = limits->inc[WHITE];
+    Limits().clock[BLACK].inc  = limits->inc[BLACK];
+    Limits().movestogo = uint8_t(limits->movesToGo);
+    Limits().moveTime  = limits->moveTime;
+    Limits().depth     = Depth(limits->depth);
+    Limits().nodes     = limits->nodes;
+    Limits().mate      = uint8_t(limits->mate);
+    Limits().infinite  = limits->infinite;
+
+    Threadpool().startThinking(de->pos, de->states);
+    return true;
+}
+
+void donStop(DONEngine *de) {
+    EngineScope engineScope{ &de->engine };
+    Threadpool().raiseStop();
+}
+
+void donPonderHit(DONEngine *de) {
+    EngineScope engineScope{ &de->engine };
+    Threadpool().ponder = false; // Switch to normal search
+}
+
+void donWait(DONEngine *de) {
+    EngineScope engineScope{ &de->engine };
+    Threadpool().mainThread()->waitIdle();
+}
+
+void donNewGame(DONEngine *de) {
+    EngineScope engineScope{ &de->engine };
+    UCI::clear();
+}
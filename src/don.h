@@ -0,0 +1,93 @@
+#pragma once
+
+/// C interface to embed DON as a library (libDON.a / libDON.so), usable from C and C++.
+/// Each DONEngine is an independent engine with its own options, hash, threads and book,
+/// all the engines of the process share the read-only data (tables, network, tablebases).
+/// Results are sent to the callbacks from the search thread of the engine,
+/// the strings given to the callbacks are valid only during the call.
+/// The messages of the engine go to the message callback, not to the standard output.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+typedef struct DONEngine DONEngine;
+
+/// Bound of the score of a PV line
+typedef enum DONBound {
+    DON_BOUND_EXACT =  0,
+    DON_BOUND_LOWER = +1,
+    DON_BOUND_UPPER = -1
+} DONBound;
+
+/// Information of one PV line, sent after each iteration
+/// With no legal moves the depth is zero and the PV is empty.
+typedef struct DONInfo {
+    int32_t  depth;
+    int32_t  selDepth;
+    int32_t  multiPV;
+    bool     mate;      // Score is a mate score
+    int32_t  score;     // Centi-pawns, or moves to mate (negative if mated) for a mate score
+    DONBound bound;
+    int32_t  wdl[3];    // Win, Draw, Loss in per mille
+    uint64_t nodes;
+    uint64_t nps;
+    uint64_t tbHits;
+    int64_t  time;      // Milli-seconds
+    int32_t  hashFull;  // Per mille, -1 if not computed
+    int32_t  pvLength;
+    char const *const *pv; // Moves in coordinate notation
+} DONInfo;
+
+/// Limits of the search, zero means no limit
+typedef struct DONLimits {
+    int64_t  time[2];   // Remaining time of white and black in milli-seconds
+    int64_t  inc[2];    // Increment of white and black in milli-seconds
+    int32_t  movesToGo;
+    int64_t  moveTime;
+    int32_t  depth;
+    uint64_t nodes;
+    int32_t  mate;
+    bool     infinite;
+    bool     ponder;
+} DONLimits;
+
+typedef void (*DONInfoCallback)(void *userData, DONInfo const *info);
+typedef void (*DONBestMoveCallback)(void *userData, char const *bestMove, char const *ponderMove);
+/// Messages of the engine (settings, errors), may be called from any thread of the engine
+typedef void (*DONMessageCallback)(void *userData, char const *message);
+
+/// donCreate() creates an engine, the first call initializes the process wide data.
+extern DONEngine* donCreate(void);
+extern void donDestroy(DONEngine*);
+
+extern void donSetCallbacks(DONEngine*, DONInfoCallback, DONBestMoveCallback, void *userData);
+/// donSetMessageCallback() sets the callback of the messages, given the user data of donSetCallbacks().
+extern void donSetMessageCallback(DONEngine*, DONMessageCallback);
+
+/// donSetOption() sets an UCI option, returns false if no such option.
+/// The options of the process wide state (Eval File, SyzygyPath, SyzygyWarmup, SyzygyBlockCache, Slider Attacks, Log File)
+/// are shared by all the engines, returns false on them while several engines exist.
+extern bool donSetOption(DONEngine*, char const *name, char const *value);
+
+/// donSetPosition() sets the position from the fen (NULL for start position) and the moves played from it,
+/// returns false on an illegal move, the position then stops before the move.
+extern bool donSetPosition(DONEngine*, char const *fen, char const *const *moves, int32_t moveCount);
+
+/// donGo() starts the search and returns immediately, bestmove is sent to the callback.
+/// Returns false without searching if the NNUE network is used but not loaded (see the messages).
+extern bool donGo(DONEngine*, DONLimits const*);
+extern void donStop(DONEngine*);
+extern void donPonderHit(DONEngine*);
+/// donWait() blocks until the search is finished.
+extern void donWait(DONEngine*);
+
+/// donNewGame() clears the hash and the history of the engine.
+extern void donNewGame(DONEngine*);
+
+#if defined(__cplusplus)
+}
+#endif
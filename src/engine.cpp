@@ -0,0 +1,76 @@
+#include "engine.h"
+
+#include "bitbase.h"
+#include "bitboard.h"
+#include "endgame.h"
+#include "evaluator.h"
+#include "psqtable.h"
+#include "syzygytb.h"
+
+thread_local Engine *ActiveEngine{ nullptr };
+
+std::atomic<uint16_t> Engine::Count{ 0 };
+
+/// Engine::initialize() initializes the read-only data shared by all the engines, once per process.
+void Engine::initialize() noexcept {
+    Bitboards::initialize();
+    Bitbases::initialize();
+    PSQT::initialize();
+    EndGame::initialize();
+}
+
+/// Engine::count() returns the number of engines living in the process.
+uint16_t Engine::count() noexcept {
+    return Count.load(std::memory_order::memory_order_relaxed);
+}
+
+/// Engine::message() sends the message to the front end, if it listens.
+void Engine::message(std::string_view msg) const {
+    if (onMessage) {
+        onMessage(msg);
+    }
+}
+
+/// Engine constructor sets up the options, book, threads and hash of a fresh engine.
+/// The process must have been initialized by Engine::initialize() before.
+Engine::Engine() :
+    threadpool{},
+    useNNUE{ false },
+    threadMarks{} {
+
+    ++Count;
+
+    EngineScope engineScope{ this };
+    UCI::initialize();
+    book.initialize(options["Book File"], options["Book Merge"] == "Sum");
+    threadpool.setup(optionThreads());
+    Evaluator::NNUE::initialize();
+    UCI::clear();
+}
+
+Engine::~Engine() {
+    EngineScope engineScope{ this };
+    threadpool.setup(0);
+    SyzygyTB::detach(this);
+
+    --Count;
+}
+
+EngineScope::EngineScope(Engine *engine) noexcept :
+    previous{ ActiveEngine } {
+    ActiveEngine = engine;
+}
+
+EngineScope::~EngineScope() noexcept {
+    ActiveEngine = previous;
+}
+
+/// Accessors of the state of the active engine
+
+UCI::OptionMap& Options() noexcept { return ActiveEngine->options; }
+TTable&         TT() noexcept { return ActiveEngine->tt; }
+ThreadPool&     Threadpool() noexcept { return ActiveEngine->threadpool; }
+PolyBook&       Book() noexcept { return ActiveEngine->book; }
+TimeManager&    TimeMgr() noexcept { return ActiveEngine->timeMgr; }
+Limit&          Limits() noexcept { return ActiveEngine->limits; }
+SkillManager&   SkillMgr() noexcept { return ActiveEngine->skillMgr; }
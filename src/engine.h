@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <string_view>
+
+#include "polyglot.h"
+#include "searcher.h"
+#include "skillmanager.h"
+#include "thread.h"
+#include "threadmarker.h"
+#include "timemanager.h"
+#include "transposition.h"
+#include "type.h"
+#include "uci.h"
+
+/// Engine keeps together all the state of one playing engine:
+/// options, transposition table, threads, book, time manager and search limits.
+/// Many engines can live in one process, they share the read-only data
+/// (bitboards, bitbases, endgames, NNUE network and tablebase mappings).
+class Engine final {
+
+public:
+
+    Engine();
+    ~Engine();
+
+    Engine(Engine const&) = delete;
+    Engine(Engine&&) = delete;
+
+    Engine& operator=(Engine const&) = delete;
+    Engine& operator=(Engine&&) = delete;
+
+    static void initialize() noexcept;
+
+    static uint16_t count() noexcept;
+
+    void message(std::string_view) const;
+
+    UCI::OptionMap options;
+    TTable         tt;
+    ThreadPool     threadpool;
+    PolyBook       book;
+    TimeManager    timeMgr;
+    Limit          limits;
+    SkillManager   skillMgr;
+    // Last position set up by the UCI front end
+    UCI::Setup     lastSetup;
+
+    // Listeners of the search output, installed by the front end (UCI or library).
+    // They are called from the main search thread.
+    std::function<void(SearchInfo const&)>   onInfo;
+    std::function<void(CurrMoveInfo const&)> onCurrMove;
+    std::function<void(Move, Move)>          onBestMove;
+    // Listener of the messages (settings, errors), they may have several lines.
+    // It may be called from any thread working for the engine.
+    std::function<void(std::string_view)>    onMessage;
+
+    bool useNNUE;
+
+    ThreadMark threadMarks[ThreadMarkSize];
+
+private:
+
+    static std::atomic<uint16_t> Count;
+};
+
+/// Engine the calling thread works for, set by the thread driving the engine
+/// and inherited by all the threads the engine starts.
+extern thread_local Engine *ActiveEngine;
+
+/// EngineScope makes the given engine active for the calling thread during its life time.
+class EngineScope final {
+
+public:
+
+    explicit EngineScope(Engine*) noexcept;
+    ~EngineScope() noexcept;
+
+    EngineScope() = delete;
+    EngineScope(EngineScope const&) = delete;
+    EngineScope(EngineScope&&) = delete;
+
+    EngineScope& operator=(EngineScope const&) = delete;
+    EngineScope& operator=(EngineScope&&) = delete;
+
+private:
+
+    Engine *previous;
+};
@@ -6,10 +6,12 @@
 #include <iomanip>
 #include <fstream>
 #include <iostream>
+#include <mutex>
 #include <sstream>
 #include <vector>
 
 #include "bitboard.h"
+#include "engine.h"
 #include "king.h"
 #include "material.h"
 #include "pawns.h"
@@ -38,7 +40,7 @@
 
 namespace Evaluator {
 
-    bool useNNUE{ false };
+    // Network shared by all the engines in the process
     std::string loadedEvalFile{ "None" };
 
     namespace NNUE {
@@ -51,12 +53,15 @@ namespace Evaluator {
         /// in the engine directory. Distro packagers may define the DEFAULT_NNUE_DIRECTORY
         /// variable to have the engine search in a special directory in their distro.
         void initialize() noexcept {
+            static std::mutex mutex;
 
-            useNNUE = Options["Use NNUE"];
-            auto evalFile{ std::string(Options["Eval File"]) };
+            ActiveEngine->useNNUE = Options()["Use NNUE"];
+            auto evalFile{ std::string(Options()["Eval File"]) };
+
+            std::lock_guard<std::mutex> lockGuard(mutex);
             if (evalFile == loadedEvalFile) return;
 
-            if (useNNUE) {
+            if (ActiveEngine->useNNUE) {
 
                 // "<internal>" embedded eval file
                 if (evalFile == DefaultEvalFile) {
@@ -87,23 +92,25 @@ namespace Evaluator {
             }
         }
 
-        void verify() noexcept {
+        /// verify() checks the network is loaded if the NNUE evaluation is used, and tells the evaluation used.
+        /// Returns false if the network is missing, the engine can't search then.
+        bool verify() {
 
-            auto evalFile{ std::string(Options["Eval File"]) };
-            if (useNNUE) {
+            auto evalFile{ std::string(Options()["Eval File"]) };
+            if (ActiveEngine->useNNUE) {
                 if (evalFile != loadedEvalFile) {
-                    sync_cout
-                        << "info string ERROR: NNUE evaluation used, but the network file " << evalFile << " was not loaded successfully.\n"
-                        << "info string ERROR: These network evaluation parameters must be available, and compatible with this version of the code.\n"
-                        << "info string ERROR: The UCI option 'Eval File' might need to specify the full path, including the directory/folder name, to the file.\n"
-                        << "info string ERROR: The default net can be downloaded from: https://tests.stockfishchess.org/api/nn/" << Options["Eval File"].defaultValue() << sync_endl;
-                    //system("pause");
-                    std::exit(EXIT_FAILURE);
+                    ActiveEngine->message(
+                        "ERROR: NNUE evaluation used, but the network file " + evalFile + " was not loaded successfully.\n"
+                        "ERROR: These network evaluation parameters must be available, and compatible with this version of the code.\n"
+                        "ERROR: The UCI option 'Eval File' might need to specify the full path, including the directory/folder name, to the file.\n"
+                        "ERROR: The default net can be downloaded from: https://tests.stockfishchess.org/api/nn/" + Options()["Eval File"].defaultValue());
+                    return false;
                 }
-                sync_cout << "info string NNUE evaluation using " << evalFile << " enabled." << sync_endl;
+                ActiveEngine->message("NNUE evaluation using " + evalFile + " enabled.");
             } else {
-                sync_cout << "info string classical evaluation enabled." << sync_endl;
+                ActiveEngine->message("classical evaluation enabled.");
             }
+            return true;
         }
     }
 
@@ -310,7 +317,7 @@ namespace Evaluator {
             Bitboard queenAttacked[COLORS][3];
 
             Bitboard mobArea[COLORS];
-            Score   mobility[COLORS];
+            Score   mobility[COLORS]{ SCORE_ZERO, SCORE_ZERO };
 
             // The squares adjacent to the king plus some other very near squares, depending on king position.
             Bitboard kingRing[COLORS];
@@ -503,7 +510,7 @@ namespace Evaluator {
                         // It is a very serious problem, especially when that pawn is also blocked.
                         // Bishop (white or black) on a1/h1 or a8/h8 which is trapped by own pawn on b2/g2 or b7/g7.
                         if (mob <= 1
-                         && Options["UCI_Chess960"]
+                         && Options()["UCI_Chess960"]
                          && (relativeSq(Own, s) == SQ_A1
                           || relativeSq(Own, s) == SQ_H1)) {
 
@@ -1137,7 +1144,7 @@ namespace Evaluator {
                 Tracer::write(Term(PAWN), pawnEntry->score[WHITE], pawnEntry->score[BLACK]);
                 Tracer::write(MATERIAL  , pos.psqScore());
                 Tracer::write(IMBALANCE , matlEntry->imbalance);
-                Tracer::write(MOBILITY  , mobility[WHITE], mobility[BLACK]);                
+                Tracer::write(MOBILITY  , mobility[WHITE], mobility[BLACK]);
                 Tracer::write(SCALING   , makeScore(mv, ev - eg + eg * Scale(scale) / SCALE_NORMAL));
                 Tracer::write(TOTAL     , makeScore(mg,         + eg * Scale(scale) / SCALE_NORMAL));
             }
@@ -1197,7 +1204,7 @@ namespace Evaluator {
 
         Value v;
 
-        if (useNNUE) {
+        if (ActiveEngine->useNNUE) {
 
             auto const npm{ pos.nonPawnMaterial() };
             // Scale and shift NNUE for compatibility with search and classical evaluation
@@ -1206,7 +1213,7 @@ namespace Evaluator {
                 int32_t const scale{ 580 + mat / 32 - 4 * pos.clockPly() };
                 Value nnueValue = NNUE::evaluate(pos) * scale / 1024 + VALUE_TEMPO;
 
-                if (Options["UCI_Chess960"]) {
+                if (Options()["UCI_Chess960"]) {
                     nnueValue += fixFRC(pos);
                 }
                 return nnueValue;
@@ -1294,7 +1301,7 @@ namespace Evaluator {
         value = (pos.activeSide() == WHITE ? +value : -value);
         oss << "\nClassical Evaluation: " << toCP(value) / 100 << " (white side)\n";
 
-        if (useNNUE) {
+        if (ActiveEngine->useNNUE) {
             value = NNUE::evaluate(pos);
             // Trace scores are from White's point of view
             value = (pos.activeSide() == WHITE ? +value : -value);
@@ -8,7 +8,6 @@ class Position;
 
 namespace Evaluator {
 
-    extern bool useNNUE;
     extern std::string loadedEvalFile;
 
     // The default net name MUST follow the format nn-[SHA256 first 12 digits].nnue
@@ -24,7 +23,7 @@ namespace Evaluator {
 
         extern void initialize() noexcept;
 
-        extern void verify() noexcept;
+        extern bool verify();
 
     }
 
@@ -1,8 +1,12 @@
 #include "memoryhandler.h"
 
+#include <algorithm>
 #include <cassert>
+#include <fstream>
 #include <memory>
 #include <iostream>
+#include <sstream>
+#include <string>
 #include <vector>
 
 #include "../type.h"
@@ -30,9 +34,18 @@
 
 #if defined(__linux__) && !defined(__ANDROID__)
     #include <cstdlib>
+    #include <pthread.h>
+    #include <sched.h>
     #include <sys/mman.h>
 #endif
 
+#if !defined(_WIN32)
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
 #if defined(__APPLE__) || defined(__ANDROID__) || defined(__OpenBSD__) || (defined(__GLIBCXX__) && !defined(_GLIBCXX_HAVE_ALIGNED_ALLOC) && !defined(_WIN32))
     #define POSIX_ALIGNED_MEM
     #include <cstdlib>
@@ -177,6 +190,76 @@ void freeAlignedLP(void *mem) noexcept {
 #endif
 }
 
+void const* mapFile(std::string_view file, uint64_t &size, uint64_t &mapping) noexcept {
+    std::string const filename{ file };
+    size = 0;
+    mapping = 0;
+
+#if defined(_WIN32)
+    HANDLE hFile = CreateFile(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (hFile == INVALID_HANDLE_VALUE) {
+        return nullptr;
+    }
+
+    DWORD hiSize;
+    DWORD const loSize = GetFileSize(hFile, &hiSize);
+    size = (uint64_t(hiSize) << 32) | loSize;
+    if (size == 0) {
+        CloseHandle(hFile);
+        return nullptr;
+    }
+
+    HANDLE hFileMap = CreateFileMapping(hFile, nullptr, PAGE_READONLY, hiSize, loSize, nullptr);
+    CloseHandle(hFile);
+    if (hFileMap == nullptr) {
+        return nullptr;
+    }
+
+    void const *mem = MapViewOfFile(hFileMap, FILE_MAP_READ, 0, 0, 0);
+    if (mem == nullptr) {
+        CloseHandle(hFileMap);
+        return nullptr;
+    }
+    mapping = (uint64_t)hFileMap;
+#else
+    int32_t hFile = ::open(filename.c_str(), O_RDONLY);
+    if (hFile == -1) {
+        return nullptr;
+    }
+
+    struct stat statbuf;
+    if (fstat(hFile, &statbuf) != 0
+     || statbuf.st_size == 0) {
+        ::close(hFile);
+        return nullptr;
+    }
+    size = statbuf.st_size;
+
+    void *mem = mmap(nullptr, size, PROT_READ, MAP_SHARED, hFile, 0);
+    ::close(hFile);
+    if (mem == MAP_FAILED) {
+        return nullptr;
+    }
+    #if defined(MADV_RANDOM)
+    madvise(mem, size, MADV_RANDOM);
+    #endif
+    mapping = size;
+#endif
+
+    return mem;
+}
+
+void unmapFile(void const *mem, uint64_t mapping) noexcept {
+
+    if (mem == nullptr) return;
+#if defined(_WIN32)
+    UnmapViewOfFile(mem);
+    CloseHandle((HANDLE)mapping);
+#else
+    munmap(const_cast<void*>(mem), mapping);
+#endif
+}
+
 /// Win Processors Group
 /// Under Windows it is not possible for a process to run on more than one logical processor group.
 /// This usually means to be limited to use max 64 cores.
@@ -312,3 +395,142 @@ namespace WinProcGroup {
 #endif
 
 }
+
+namespace Affinity {
+
+    namespace {
+
+#if defined(__linux__) && !defined(__ANDROID__)
+
+        /// LogicalCPU keeps the topology of a logical processor
+        struct LogicalCPU {
+            uint16_t cpu;
+            uint16_t package;
+            uint16_t core;
+            uint16_t sibling; // Index among the hyperthread siblings of the core
+            uint16_t rank;    // Index of the core within the package
+        };
+
+        /// parseList() parses a cpu list like "0-3,8,10-11".
+        std::vector<uint16_t> parseList(std::string_view list) {
+            std::vector<uint16_t> cpus;
+
+            std::istringstream iss{ std::string{ list } };
+            std::string range;
+            while (std::getline(iss, range, ',')) {
+                int32_t beg{ -1 }, end{ -1 };
+                char dash;
+                std::istringstream rss{ range };
+                if (!(rss >> beg)) {
+                    continue;
+                }
+                end = (rss >> dash >> end) && dash == '-' ? end : beg;
+                for (int32_t cpu = beg; cpu <= end; ++cpu) {
+                    if (0 <= cpu && cpu < CPU_SETSIZE) {
+                        cpus.push_back(uint16_t(cpu));
+                    }
+                }
+            }
+            return cpus;
+        }
+
+        std::string readTopology(uint16_t cpu, char const *name) {
+            std::ifstream ifstream{ "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/" + name };
+            std::string value;
+            std::getline(ifstream, value);
+            return value;
+        }
+
+        /// topology() reads the topology of the logical processors the process is allowed to run on.
+        std::vector<LogicalCPU> topology() {
+            std::vector<LogicalCPU> lCPUs;
+
+            cpu_set_t cpuSet;
+            CPU_ZERO(&cpuSet);
+            if (sched_getaffinity(0, sizeof (cpuSet), &cpuSet) != 0) {
+                return lCPUs;
+            }
+
+            for (uint16_t cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                if (!CPU_ISSET(cpu, &cpuSet)) {
+                    continue;
+                }
+                // Missing topology is treated as a single package with one thread per core
+                auto const package{ readTopology(cpu, "physical_package_id") };
+                auto const core{ readTopology(cpu, "core_id") };
+                auto const siblings{ parseList(readTopology(cpu, "thread_siblings_list")) };
+
+                LogicalCPU lCPU{ cpu, 0, cpu, 0, 0 };
+                if (!package.empty()) {
+                    lCPU.package = uint16_t(std::max(std::atoi(package.c_str()), 0));
+                }
+                if (!core.empty()) {
+                    lCPU.core = uint16_t(std::max(std::atoi(core.c_str()), 0));
+                }
+                lCPU.sibling = uint16_t(std::count_if(siblings.begin(), siblings.end(), [cpu](uint16_t s) { return s < cpu; }));
+                lCPUs.push_back(lCPU);
+            }
+
+            // Rank the cores within each package
+            std::sort(lCPUs.begin(), lCPUs.end(), [](LogicalCPU const &c1, LogicalCPU const &c2) {
+                return c1.package != c2.package ? c1.package < c2.package :
+                       c1.core    != c2.core    ? c1.core    < c2.core    : c1.cpu < c2.cpu;
+            });
+            for (size_t i = 1; i < lCPUs.size(); ++i) {
+                lCPUs[i].rank = lCPUs[i].package != lCPUs[i - 1].package ? 0 :
+                                lCPUs[i].core    != lCPUs[i - 1].core    ? lCPUs[i - 1].rank + 1 : lCPUs[i - 1].rank;
+            }
+            return lCPUs;
+        }
+
+#endif
+    }
+
+    /// setup() returns the logical processors in the order the threads are placed on with the given policy,
+    /// the list is used by AFFINITY_LIST policy. Each engine keeps its own placement.
+    /// Threads must be recreated afterwards for the placement to take effect.
+    std::vector<uint16_t> setup([[maybe_unused]] AffinityPolicy policy, [[maybe_unused]] std::string_view list) {
+        std::vector<uint16_t> cpus;
+
+#if defined(__linux__) && !defined(__ANDROID__)
+        if (policy == AFFINITY_LIST) {
+            cpus = parseList(list);
+            return cpus;
+        }
+        if (policy == AFFINITY_NONE) {
+            return cpus;
+        }
+
+        auto lCPUs{ topology() };
+        // Compact order is the topology order: siblings of a core are adjacent
+        if (policy == AFFINITY_SCATTER) {
+            std::stable_sort(lCPUs.begin(), lCPUs.end(), [](LogicalCPU const &c1, LogicalCPU const &c2) {
+                return c1.sibling != c2.sibling ? c1.sibling < c2.sibling : c1.rank < c2.rank;
+            });
+        } else
+        if (policy == AFFINITY_PHYSICAL) {
+            std::stable_sort(lCPUs.begin(), lCPUs.end(), [](LogicalCPU const &c1, LogicalCPU const &c2) {
+                return c1.sibling < c2.sibling;
+            });
+        }
+        for (auto const &lCPU : lCPUs) {
+            cpus.push_back(lCPU.cpu);
+        }
+#endif
+        return cpus;
+    }
+
+    /// bind() pins the calling thread to the logical processor of the thread index in the placement.
+    /// If there are more threads than logical processors, the extra ones are left to the OS.
+    void bind([[maybe_unused]] std::vector<uint16_t> const &cpus, [[maybe_unused]] uint16_t index) noexcept {
+#if defined(__linux__) && !defined(__ANDROID__)
+        if (index >= cpus.size()) {
+            return;
+        }
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        CPU_SET(cpus[index], &cpuSet);
+        pthread_setaffinity_np(pthread_self(), sizeof (cpuSet), &cpuSet);
+#endif
+    }
+}
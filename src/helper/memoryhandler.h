@@ -2,6 +2,8 @@
 
 #include <cstdint>
 #include <cstddef>
+#include <string_view>
+#include <vector>
 
 // `ptr` must point to an array of size at least
 // `sizeof(T) * N + alignment` bytes, where `N` is the
@@ -20,6 +22,12 @@ extern void  freeAlignedStd(void*) noexcept;
 extern void* allocAlignedLP(size_t) noexcept;
 extern void  freeAlignedLP(void*) noexcept;
 
+/// mapFile() maps the whole file read-only and shared, the pages are loaded on demand
+/// and shared with the other processes mapping the same file.
+/// Returns nullptr on failure, the size and the mapping handle are needed to unmap.
+extern void const* mapFile(std::string_view, uint64_t&, uint64_t&) noexcept;
+extern void        unmapFile(void const*, uint64_t) noexcept;
+
 /// Win Processors Group
 /// Under Windows it is not possible for a process to run on more than one logical processor group.
 /// This usually means to be limited to use max 64 cores.
@@ -29,3 +37,20 @@ namespace WinProcGroup {
 
     extern void bind(uint16_t);
 }
+
+enum AffinityPolicy : uint8_t {
+    AFFINITY_NONE,      // Let the OS place the threads
+    AFFINITY_COMPACT,   // Fill all logical processors of a core, then the next core
+    AFFINITY_SCATTER,   // Spread over packages and cores, hyperthread siblings last
+    AFFINITY_PHYSICAL,  // One thread per physical core of each package in turn, hyperthread siblings last
+    AFFINITY_LIST,      // Explicit list of logical processors
+};
+
+/// Thread Affinity
+/// Places the threads on the logical processors according to the policy,
+/// using the CPU topology from sysfs. Only implemented on Linux, elsewhere it is a no-op.
+namespace Affinity {
+
+    extern std::vector<uint16_t> setup(AffinityPolicy, std::string_view = "");
+    extern void bind(std::vector<uint16_t> const&, uint16_t) noexcept;
+}
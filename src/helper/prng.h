@@ -22,7 +22,7 @@ class PRNG {
 
 public:
 
-    PRNG(uint64_t seed) noexcept :
+    constexpr PRNG(uint64_t seed) noexcept :
         x{ seed } {
         assert(x != 0);
     }
@@ -34,7 +34,7 @@ public:
     PRNG& operator=(PRNG&&) = delete;
 
     template<typename T>
-    T rand() noexcept {
+    constexpr T rand() noexcept {
         return T(rand64());
     }
 
@@ -42,14 +42,14 @@ public:
     /// Special generator used to fast initialize magic numbers.
     /// Output values only have 1/8th of their bits set on average.
     template<typename T>
-    T sparseRand() noexcept {
+    constexpr T sparseRand() noexcept {
         return T(rand64() & rand64() & rand64());
     }
 //#endif
 
 private:
 
-    uint64_t rand64() noexcept {
+    constexpr uint64_t rand64() noexcept {
         x ^= x >> 12;
         x ^= x << 25;
         x ^= x >> 27;
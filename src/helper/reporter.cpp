@@ -1,67 +1,283 @@
 #include "reporter.h"
 
+#include <algorithm>
+#include <atomic>
 #include <iomanip>
 #include <iostream>
+#include <limits>
+#include <mutex>
 #include <sstream>
+#include <vector>
+
+#include "../bitboard.h"
 
 namespace Reporter {
 
     namespace {
 
-        std::atomic<uint64_t> Hit1Count{ 0 };
-        std::atomic<uint64_t> Hit2Count{ 0 };
+        // Logarithmic buckets of the items: negatives, zero, positives
+        constexpr uint8_t Buckets{ 1 + 2 * 64 };
+        constexpr uint8_t ZeroBucket{ 64 };
+
+        /// bucketOf() returns the bucket of the item, by the count of bits of its magnitude.
+        uint8_t bucketOf(int64_t item) noexcept {
+            if (item == 0) {
+                return ZeroBucket;
+            }
+            auto const magnitude{ item > 0 ? uint64_t(item) : uint64_t(-(item + 1)) + 1 };
+            auto const bits{ uint8_t(scanMSq(magnitude) + 1) };
+            return item > 0 ? ZeroBucket + bits : ZeroBucket - bits;
+        }
+        /// lowerOf() and upperOf() return the bounds of the items in the bucket.
+        int64_t lowerOf(uint8_t bucket) noexcept {
+            if (bucket == ZeroBucket) {
+                return 0;
+            }
+            if (bucket == 0) {
+                return std::numeric_limits<int64_t>::min();
+            }
+            return bucket > ZeroBucket ?
+                    +int64_t(uint64_t(1) << (bucket - ZeroBucket - 1)) :
+                    -int64_t((uint64_t(1) << (ZeroBucket - bucket)) - 1);
+        }
+        int64_t upperOf(uint8_t bucket) noexcept {
+            if (bucket == ZeroBucket) {
+                return 0;
+            }
+            return bucket > ZeroBucket ?
+                    +int64_t((uint64_t(1) << (bucket - ZeroBucket)) - 1) :
+                    -int64_t((uint64_t(1) << (ZeroBucket - bucket - 1)) - 1) - 1;
+        }
+
+        /// add() adds to a counter written only by its owner thread, so no read-modify-write is needed.
+        /// It is atomic only for the merging thread to read it safely.
+        template<typename T>
+        inline void add(std::atomic<T> &counter, T value) noexcept {
+            counter.store(counter.load(std::memory_order::memory_order_relaxed) + value, std::memory_order::memory_order_relaxed);
+        }
+
+        /// Counters of one slot in the shard of a thread
+        struct Counters {
+
+            void clear() noexcept {
+                hit1Count = 0;
+                hit2Count = 0;
+                itemCount = 0;
+                itemSum = 0;
+                itemMin = 0;
+                itemMax = 0;
+                for (auto &count : bucketCounts) {
+                    count = 0;
+                }
+            }
+
+            std::atomic<uint64_t> hit1Count;
+            std::atomic<uint64_t> hit2Count;
+            std::atomic<uint64_t> itemCount;
+            std::atomic< int64_t> itemSum;
+            std::atomic< int64_t> itemMin;
+            std::atomic< int64_t> itemMax;
+            std::atomic<uint64_t> bucketCounts[Buckets];
+        };
+
+        /// Totals of one slot, merged from the shards
+        struct Totals {
 
-        std::atomic<uint32_t> ItemCount{ 0 };
-        std::atomic< int64_t> ItemSum{ 0 };
+            void merge(Counters const &counters) noexcept {
+                auto const count{ counters.itemCount.load(std::memory_order::memory_order_relaxed) };
+                if (count != 0) {
+                    auto const min{ counters.itemMin.load(std::memory_order::memory_order_relaxed) };
+                    auto const max{ counters.itemMax.load(std::memory_order::memory_order_relaxed) };
+                    itemMin = itemCount != 0 ? std::min(min, itemMin) : min;
+                    itemMax = itemCount != 0 ? std::max(max, itemMax) : max;
+                }
+                hit1Count += counters.hit1Count.load(std::memory_order::memory_order_relaxed);
+                hit2Count += counters.hit2Count.load(std::memory_order::memory_order_relaxed);
+                itemCount += count;
+                itemSum   += counters.itemSum.load(std::memory_order::memory_order_relaxed);
+                for (uint8_t b = 0; b < Buckets; ++b) {
+                    bucketCounts[b] += counters.bucketCounts[b].load(std::memory_order::memory_order_relaxed);
+                }
+            }
+            void merge(Totals const &totals) noexcept {
+                if (totals.itemCount != 0) {
+                    itemMin = itemCount != 0 ? std::min(totals.itemMin, itemMin) : totals.itemMin;
+                    itemMax = itemCount != 0 ? std::max(totals.itemMax, itemMax) : totals.itemMax;
+                }
+                hit1Count += totals.hit1Count;
+                hit2Count += totals.hit2Count;
+                itemCount += totals.itemCount;
+                itemSum   += totals.itemSum;
+                for (uint8_t b = 0; b < Buckets; ++b) {
+                    bucketCounts[b] += totals.bucketCounts[b];
+                }
+            }
+
+            /// percentile() returns the percentile interpolated in its bucket, within the min and max.
+            int64_t percentile(double percent) const noexcept {
+                auto const rank{ uint64_t(percent / 100 * (itemCount - 1)) };
+                uint64_t count{ 0 };
+                for (uint8_t b = 0; b < Buckets; ++b) {
+                    if (count + bucketCounts[b] > rank) {
+                        auto const lower{ std::max(lowerOf(b), itemMin) };
+                        auto const upper{ std::min(upperOf(b), itemMax) };
+                        return lower + int64_t((double(upper) - double(lower)) * (rank - count + 0.5) / bucketCounts[b]);
+                    }
+                    count += bucketCounts[b];
+                }
+                return itemMax;
+            }
+
+            uint64_t hit1Count{ 0 };
+            uint64_t hit2Count{ 0 };
+            uint64_t itemCount{ 0 };
+            int64_t  itemSum{ 0 };
+            int64_t  itemMin{ 0 };
+            int64_t  itemMax{ 0 };
+            uint64_t bucketCounts[Buckets]{};
+        };
+
+        struct Shard;
+
+        std::mutex Mutex;
+        std::vector<Shard*> Shards;
+        Totals Retired[MaxSlots]; // Counters of the exited threads
+
+        std::string Names[MaxSlots]{ "default" };
+        Slot SlotCount{ 1 };
+
+        /// Shard keeps the counters of one thread, registered for merging during the life of the thread.
+        struct Shard {
+
+            Shard() noexcept {
+                for (auto &counters : slots) {
+                    counters.clear();
+                }
+                std::lock_guard<std::mutex> lock(Mutex);
+                Shards.push_back(this);
+            }
+            ~Shard() {
+                std::lock_guard<std::mutex> lock(Mutex);
+                for (Slot s = 0; s < MaxSlots; ++s) {
+                    Retired[s].merge(slots[s]);
+                }
+                Shards.erase(std::find(Shards.begin(), Shards.end(), this));
+            }
+
+            Counters slots[MaxSlots];
+        };
+
+        thread_local Shard LocalShard;
     }
 
-    void reset() noexcept {
+    Slot slot(std::string_view name) noexcept {
+        std::lock_guard<std::mutex> lock(Mutex);
 
-        Hit1Count = 0;
-        Hit2Count = 0;
+        auto const *const itr{ std::find(Names, Names + SlotCount, name) };
+        if (itr != Names + SlotCount) {
+            return Slot(itr - Names);
+        }
+        // No more free slot, share the default one
+        if (SlotCount == MaxSlots) {
+            return 0;
+        }
+        Names[SlotCount] = name;
+        return SlotCount++;
+    }
 
-        ItemCount = 0;
-        ItemSum = 0;
+    /// reset() clears all the counters, when the threads are not counting
+    void reset() noexcept {
+        std::lock_guard<std::mutex> lock(Mutex);
+
+        for (auto *shard : Shards) {
+            for (auto &counters : shard->slots) {
+                counters.clear();
+            }
+        }
+        for (auto &totals : Retired) {
+            totals = Totals{};
+        }
     }
 
-    void hitOn(bool hit2) noexcept {
-        ++Hit1Count;
+    void hitOnSlot(Slot s, bool hit2) noexcept {
+        auto &counters{ LocalShard.slots[s] };
+        add(counters.hit1Count, uint64_t(1));
         if (hit2) {
-            ++Hit2Count;
+            add(counters.hit2Count, uint64_t(1));
         }
     }
-    void hitOn(bool hit1, bool hit2) noexcept {
+    void hitOnSlot(Slot s, bool hit1, bool hit2) noexcept {
         if (hit1) {
-            hitOn(hit2);
+            hitOnSlot(s, hit2);
         }
     }
+    void hitOn(bool hit2) noexcept {
+        hitOnSlot(Slot(0), hit2);
+    }
+    void hitOn(bool hit1, bool hit2) noexcept {
+        hitOnSlot(Slot(0), hit1, hit2);
+    }
 
+    void meanOfSlot(Slot s, int64_t item) noexcept {
+        auto &counters{ LocalShard.slots[s] };
+        auto const count{ counters.itemCount.load(std::memory_order::memory_order_relaxed) };
+        if (count == 0
+         || counters.itemMin.load(std::memory_order::memory_order_relaxed) > item) {
+            counters.itemMin.store(item, std::memory_order::memory_order_relaxed);
+        }
+        if (count == 0
+         || counters.itemMax.load(std::memory_order::memory_order_relaxed) < item) {
+            counters.itemMax.store(item, std::memory_order::memory_order_relaxed);
+        }
+        add(counters.itemCount, uint64_t(1));
+        add(counters.itemSum, item);
+        add(counters.bucketCounts[bucketOf(item)], uint64_t(1));
+    }
     void meanOf(int64_t item) noexcept {
-        ++ItemCount;
-        ItemSum += item;
+        meanOfSlot(Slot(0), item);
     }
 
-    void print() {
+    /// toString() returns the counters of all the threads merged, per slot.
+    std::string toString() {
+        std::lock_guard<std::mutex> lock(Mutex);
+
+        std::ostringstream oss;
+        oss << std::right;
+        for (Slot s = 0; s < SlotCount; ++s) {
+            Totals totals{ Retired[s] };
+            for (auto const *shard : Shards) {
+                totals.merge(shard->slots[s]);
+            }
 
-        if (Hit1Count != 0) {
-            std::ostringstream oss;
-            oss << std::right
-                << "---------------------------\n"
-                << "Hit1  :" << std::setw(20) << Hit1Count << '\n'
-                << "Hit2  :" << std::setw(20) << Hit2Count << '\n'
-                << "Rate  :" << std::setw(20) << std::fixed << std::setprecision(2)
-                << 100 * (double)Hit2Count / Hit1Count;
-            std::cerr << oss.str() << '\n';
+            if (totals.hit1Count != 0) {
+                oss << "---------------------------\n"
+                    << "Slot  :" << std::setw(20) << Names[s] << '\n'
+                    << "Hit1  :" << std::setw(20) << totals.hit1Count << '\n'
+                    << "Hit2  :" << std::setw(20) << totals.hit2Count << '\n'
+                    << "Rate  :" << std::setw(20) << std::fixed << std::setprecision(2)
+                    << 100 * (double)totals.hit2Count / totals.hit1Count << '\n';
+            }
+            if (totals.itemCount != 0) {
+                oss << "---------------------------\n"
+                    << "Slot  :" << std::setw(20) << Names[s] << '\n'
+                    << "Count :" << std::setw(20) << totals.itemCount << '\n'
+                    << "Sum   :" << std::setw(20) << totals.itemSum << '\n'
+                    << "Mean  :" << std::setw(20) << std::fixed << std::setprecision(2)
+                    << (double)totals.itemSum / totals.itemCount << '\n'
+                    << "Min   :" << std::setw(20) << totals.itemMin << '\n'
+                    << "P50   :" << std::setw(20) << totals.percentile(50) << '\n'
+                    << "P90   :" << std::setw(20) << totals.percentile(90) << '\n'
+                    << "P99   :" << std::setw(20) << totals.percentile(99) << '\n'
+                    << "Max   :" << std::setw(20) << totals.itemMax << '\n';
+            }
         }
-        if (ItemCount != 0) {
-            std::ostringstream oss;
-            oss << std::right
-                << "---------------------------\n"
-                << "Count :" << std::setw(20) << ItemCount << '\n'
-                << "Sum   :" << std::setw(20) << ItemSum << '\n'
-                << "Mean  :" << std::setw(20) << std::fixed << std::setprecision(2)
-                << (double)ItemSum / ItemCount;
-            std::cerr << oss.str() << '\n';
+        return oss.str();
+    }
+
+    void print() {
+        auto const str{ toString() };
+        if (!str.empty()) {
+            std::cerr << str;
         }
     }
 }
@@ -1,17 +1,33 @@
 #pragma once
 
 #include <cstdint>
-#include <atomic>
+#include <string>
+#include <string_view>
 
-// Reporter mainly collects run-time statistics and print them
+// Reporter mainly collects run-time statistics and print them.
+// Each thread counts into its own shard, so counting never contends,
+// the shards are merged only when reporting.
 namespace Reporter {
 
+    using Slot = uint8_t;
+
+    constexpr Slot MaxSlots{ 16 };
+
+    // Slot returns the slot of the given name, registering it on first use (slot 0 is "default").
+    // Get it once, e.g. static auto const slot{ Reporter::slot("name") };
+    extern Slot slot(std::string_view) noexcept;
+
     extern void reset() noexcept;
 
     extern void hitOn(bool) noexcept;
     extern void hitOn(bool, bool) noexcept;
+    // Named apart from hitOn(bool, bool) and meanOf(int64_t), an integer argument would be ambiguous
+    extern void hitOnSlot(Slot, bool) noexcept;
+    extern void hitOnSlot(Slot, bool, bool) noexcept;
 
     extern void meanOf(int64_t) noexcept;
+    extern void meanOfSlot(Slot, int64_t) noexcept;
 
+    extern std::string toString();
     extern void print();
 }
@@ -179,6 +179,181 @@ namespace {
 
         generatePieceMoves<GT == QUIET_CHECK>(moves, pos, targets);
     }
+
+    /// Splits the pawns which can legally move by the direction (push, left-attack, right-attack).
+    /// Pinned pawns can only move along the line from the king.
+    template<Color Own>
+    void legalPawns(Position const &pos, Bitboard pinneds, Bitboard &pushPawns, Bitboard &lAttPawns, Bitboard &rAttPawns) noexcept {
+
+        Bitboard const pawns{ pos.pieces(Own, PAWN) };
+        pushPawns =
+        lAttPawns =
+        rAttPawns = pawns & ~pinneds;
+
+        Bitboard pinnedPawns{ pawns & pinneds };
+        while (pinnedPawns != 0) {
+            auto const s{ popLSq(pinnedPawns) };
+            Bitboard const line{ lineBB(pos.square(Own|KING), s) };
+            if ((line & pawnSglPushBB<Own>(squareBB(s))) != 0) { pushPawns |= s; }
+            if ((line & pawnLAttackBB<Own>(squareBB(s))) != 0) { lAttPawns |= s; }
+            if ((line & pawnRAttackBB<Own>(squareBB(s))) != 0) { rAttPawns |= s; }
+        }
+    }
+
+    /// Enpassant is rare, so test the king safety directly with the resulting occupancy.
+    template<Color Own>
+    Bitboard legalEpPawns(Position const &pos) noexcept {
+        constexpr auto Opp{ ~Own };
+
+        Bitboard legals{ 0 };
+        if (pos.epSquare() != SQ_NONE) {
+            assert(relativeRank(Own, pos.epSquare()) == RANK_6);
+            auto const cap{ pos.epSquare() - PawnPush[Own] };
+
+            Bitboard epPawns{ pos.pieces(Own, PAWN) & pawnAttacksBB(Opp, pos.epSquare()) };
+            while (epPawns != 0) {
+                auto const org{ popLSq(epPawns) };
+                Bitboard const mocc{ (pos.pieces() ^ org ^ cap) | pos.epSquare() };
+                if ((pos.attackersTo(pos.square(Own|KING), mocc) & pos.pieces(Opp) & ~squareBB(cap)) == 0) {
+                    legals |= org;
+                }
+            }
+        }
+        return legals;
+    }
+
+    /// Generates pawn legal move, in the same order as generatePawnMoves()
+    template<Color Own>
+    void generateLegalPawnMoves(ValMoves &moves, Position const &pos, Bitboard mask, Bitboard pinneds) noexcept {
+        constexpr auto Opp{ ~Own };
+
+        Bitboard const empties{ ~pos.pieces() };
+        Bitboard const enemies{  pos.pieces(Opp) & mask };
+
+        Bitboard pushPawns, lAttPawns, rAttPawns;
+        legalPawns<Own>(pos, pinneds, pushPawns, lAttPawns, rAttPawns);
+
+        Bitboard const r7Rank{ rankBB(relativeRank(Own, RANK_7)) };
+
+        Bitboard pushs1{ empties & pawnSglPushBB<Own>(pushPawns & ~r7Rank) };
+        Bitboard pushs2{ empties & pawnSglPushBB<Own>(pushs1 & rankBB(relativeRank(Own, RANK_3))) & mask };
+        pushs1 &= mask;
+        while (pushs1 != 0) { auto const dst{ popLSq(pushs1) }; moves += makeMove(dst - PawnPush[Own], dst); }
+        while (pushs2 != 0) { auto const dst{ popLSq(pushs2) }; moves += makeMove(dst - PawnPush[Own]*2, dst); }
+
+        if ((pos.pieces(Own, PAWN) & r7Rank) != 0) {
+            generatePromotionMoves<NORMAL>(moves, pos, enemies & pawnLAttackBB<Own>(lAttPawns & r7Rank), PawnLAtt[Own]);
+            generatePromotionMoves<NORMAL>(moves, pos, enemies & pawnRAttackBB<Own>(rAttPawns & r7Rank), PawnRAtt[Own]);
+            generatePromotionMoves<NORMAL>(moves, pos, empties & mask & pawnSglPushBB<Own>(pushPawns & r7Rank), PawnPush[Own]);
+        }
+
+        Bitboard attacksL{ enemies & pawnLAttackBB<Own>(lAttPawns & ~r7Rank) };
+        Bitboard attacksR{ enemies & pawnRAttackBB<Own>(rAttPawns & ~r7Rank) };
+        while (attacksL != 0) { auto const dst{ popLSq(attacksL) }; moves += makeMove(dst - PawnLAtt[Own], dst); }
+        while (attacksR != 0) { auto const dst{ popLSq(attacksR) }; moves += makeMove(dst - PawnRAtt[Own], dst); }
+
+        Bitboard epPawns{ legalEpPawns<Own>(pos) };
+        while (epPawns != 0) { moves += makeMove<ENPASSANT>(popLSq(epPawns), pos.epSquare()); }
+    }
+
+    /// Counts pawn legal moves without generating them.
+    template<Color Own>
+    uint16_t countLegalPawnMoves(Position const &pos, Bitboard mask, Bitboard pinneds) noexcept {
+        constexpr auto Opp{ ~Own };
+
+        Bitboard const empties{ ~pos.pieces() };
+        Bitboard const enemies{  pos.pieces(Opp) & mask };
+
+        Bitboard pushPawns, lAttPawns, rAttPawns;
+        legalPawns<Own>(pos, pinneds, pushPawns, lAttPawns, rAttPawns);
+
+        Bitboard const r7Rank{ rankBB(relativeRank(Own, RANK_7)) };
+
+        Bitboard const pushs1{ empties & pawnSglPushBB<Own>(pushPawns & ~r7Rank) };
+        Bitboard const pushs2{ empties & pawnSglPushBB<Own>(pushs1 & rankBB(relativeRank(Own, RANK_3))) };
+
+        return uint16_t( popCount(pushs1 & mask)
+                       + popCount(pushs2 & mask)
+                       + popCount(enemies & pawnLAttackBB<Own>(lAttPawns & ~r7Rank))
+                       + popCount(enemies & pawnRAttackBB<Own>(rAttPawns & ~r7Rank))
+                       + 4 * ( popCount(enemies & pawnLAttackBB<Own>(lAttPawns & r7Rank))
+                             + popCount(enemies & pawnRAttackBB<Own>(rAttPawns & r7Rank))
+                             + popCount(empties & mask & pawnSglPushBB<Own>(pushPawns & r7Rank)) )
+                       + popCount(legalEpPawns<Own>(pos)) );
+    }
+
+    /// Returns the legal attacks of the piece, pinned piece can only move along the line from the king
+    inline Bitboard legalAttacks(Position const &pos, PieceType pt, Square s, Bitboard mask, Bitboard pinneds) noexcept {
+        Bitboard const attacks{ attacksBB(pt, s, pos.pieces()) & mask };
+        return contains(pinneds, s) ?
+                attacks & lineBB(pos.square(pos.activeSide()|KING), s) : attacks;
+    }
+
+    /// Returns the legal king moves (excluding castling)
+    inline Bitboard legalKingAttacks(Position const &pos) noexcept {
+        auto const kSq{ pos.square(pos.activeSide()|KING) };
+
+        Bitboard legals{ 0 };
+        Bitboard attacks{ attacksBB(KING, kSq) & ~pos.pieces(pos.activeSide()) };
+        while (attacks != 0) {
+            auto const dst{ popLSq(attacks) };
+            if ((pos.attackersTo(dst, pos.pieces() ^ kSq) & pos.pieces(~pos.activeSide())) == 0) {
+                legals |= dst;
+            }
+        }
+        return legals;
+    }
+
+    /// Returns the check mask: squares where a non-king piece has to move to.
+    /// Blocking or capturing the checker when in check, else any square not occupied by own pieces.
+    inline Bitboard checkMask(Position const &pos) noexcept {
+        return pos.checkers() == 0 ?
+                ~pos.pieces(pos.activeSide()) :
+                pos.checkers() | betweenBB(pos.square(pos.activeSide()|KING), scanLSq(pos.checkers()));
+    }
+
+    inline bool legalCastle(Position const &pos, CastleSide cs) noexcept {
+        return pos.castleRookSq(pos.activeSide(), cs) != SQ_NONE
+            && pos.castleExpeded(pos.activeSide(), cs)
+            && pos.canCastle(pos.activeSide(), cs)
+            && pos.legal(makeMove<CASTLE>(pos.square(pos.activeSide()|KING), pos.castleRookSq(pos.activeSide(), cs)));
+    }
+}
+
+/// legalMoveCount() counts all legal moves directly from bitboards, without generating them.
+/// Used by perft for the bulk-counting of the leaf nodes.
+uint16_t legalMoveCount(Position const &pos) noexcept {
+
+    uint16_t count( popCount(legalKingAttacks(pos)) );
+
+    // Double-check, only king move can save the day
+    if (moreThanOne(pos.checkers())) {
+        return count;
+    }
+
+    Bitboard const mask{ checkMask(pos) };
+    Bitboard const pinneds{ pos.kingBlockers(pos.activeSide()) & pos.pieces(pos.activeSide()) };
+
+    count += pos.activeSide() == WHITE ?
+                countLegalPawnMoves<WHITE>(pos, mask, pinneds) :
+                countLegalPawnMoves<BLACK>(pos, mask, pinneds);
+
+    for (PieceType const pt : { NIHT, BSHP, ROOK, QUEN }) {
+        Bitboard bb{ pos.pieces(pos.activeSide(), pt) };
+        while (bb != 0) {
+            count += uint16_t( popCount(legalAttacks(pos, pt, popLSq(bb), mask, pinneds)) );
+        }
+    }
+
+    if (pos.checkers() == 0
+     && pos.canCastle(pos.activeSide())) {
+        for (CastleSide const cs : { CS_KING, CS_QUEN }) {
+            if (legalCastle(pos, cs)) {
+                ++count;
+            }
+        }
+    }
+    return count;
 }
 
 template<GenType GT>
@@ -253,26 +428,44 @@ template<> void generate<QUIET_CHECK>(ValMoves &moves, Position const &pos) noex
 }
 
 /// generate<LEGAL>       Generates all legal moves.
+/// Moves are legal by construction using the check mask and the king blockers (pinned pieces),
+/// and come out in the same order as the pseudo-legal generate<NORMAL> / generate<EVASION>.
 template<> void generate<LEGAL>(ValMoves &moves, Position const &pos) noexcept {
 
     moves.reserve(64 - 48 * (pos.checkers() != 0));
 
-    pos.checkers() == 0 ?
-        generate<NORMAL>(moves, pos) :
-        generate<EVASION>(moves, pos);
-
-    // Filter illegal moves
-    moves.erase(std::remove_if(moves.begin(), moves.end(),
-                                [&](ValMove const &vm) {
-                                    return (mType(vm) == SIMPLE
-                                         && orgSq(vm) == pos.square(pos.activeSide()|KING)
-                                         && (pos.attackersTo(dstSq(vm), pos.pieces() ^ orgSq(vm)) & pos.pieces(~pos.activeSide())) != 0)
-                                        || ((mType(vm) == CASTLE
-                                          || mType(vm) == ENPASSANT
-                                            // Pinned pieces
-                                          || pos.isKingBlockersOn(pos.activeSide(), orgSq(vm)))
-                                         && !pos.legal(vm));
-                                }), moves.end());
+    auto const kSq{ pos.square(pos.activeSide()|KING) };
+
+    // Double-check, only king move can save the day
+    if (!moreThanOne(pos.checkers())) {
+        Bitboard const mask{ checkMask(pos) };
+        Bitboard const pinneds{ pos.kingBlockers(pos.activeSide()) & pos.pieces(pos.activeSide()) };
+
+        pos.activeSide() == WHITE ?
+            generateLegalPawnMoves<WHITE>(moves, pos, mask, pinneds) :
+            generateLegalPawnMoves<BLACK>(moves, pos, mask, pinneds);
+
+        for (PieceType const pt : { NIHT, BSHP, ROOK, QUEN }) {
+            Bitboard bb{ pos.pieces(pos.activeSide(), pt) };
+            while (bb != 0) {
+                auto const s{ popLSq(bb) };
+                Bitboard attacks{ legalAttacks(pos, pt, s, mask, pinneds) };
+                while (attacks != 0) { moves += makeMove(s, popLSq(attacks)); }
+            }
+        }
+    }
+
+    Bitboard attacks{ legalKingAttacks(pos) };
+    while (attacks != 0) { moves += makeMove(kSq, popLSq(attacks)); }
+
+    if (pos.checkers() == 0
+     && pos.canCastle(pos.activeSide())) {
+        for (CastleSide const cs : { CS_KING, CS_QUEN }) {
+            if (legalCastle(pos, cs)) {
+                moves += makeMove<CASTLE>(kSq, pos.castleRookSq(pos.activeSide(), cs));
+            }
+        }
+    }
 }
 
 void Perft::operator+=(Perft const &perft) noexcept {
@@ -399,11 +592,14 @@ Perft perft(Position &pos, Depth depth, bool detail) noexcept {
             pos.doMove(vm, si);
 
             if (depth <= 2) {
-                for (auto &ivm : MoveList<LEGAL>(pos)) {
-                    ++leaf.any;
-                    if (detail) {
+                if (detail) {
+                    for (auto &ivm : MoveList<LEGAL>(pos)) {
+                        ++leaf.any;
                         leaf.classify(pos, ivm);
                     }
+                } else {
+                    // Bulk-counting, the last ply is not generated
+                    leaf.any += legalMoveCount(pos);
                 }
             } else {
                 leaf = perft<false>(pos, depth - 1, detail);
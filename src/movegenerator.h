@@ -39,6 +39,8 @@ public:
     MoveList& operator=(MoveList&&) = delete;
 };
 
+extern uint16_t legalMoveCount(Position const&) noexcept;
+
 struct Perft {
 
     void classify(Position&, Move) noexcept;
@@ -148,42 +148,59 @@ MovePicker::MovePicker(
 /// value() assigns a numerical value to each move, used for sorting.
 /// Captures are ordered by Most Valuable Victim (MVV) with using the histories.
 /// Quiets are ordered using the histories.
+/// Moves are valued in one batched pass, the loop invariant stats rows are looked up only once.
 template<GenType GT>
 void MovePicker::value() noexcept {
     static_assert(GT == CAPTURE
                 || GT == QUIET
                 || GT == EVASION, "GT incorrect");
 
-    for (auto vm{ vmBeg }; vm < vmEnd; ++vm) {
+    if constexpr (GT == CAPTURE) {
 
-        switch (GT) {
+        for (auto vm{ vmBeg }; vm < vmEnd; ++vm) {
+            auto const captured{ pos.captured(*vm) };
 
-        case CAPTURE: {
-            vm->value = int32_t(PieceValues[MG][pos.captured(*vm)]) * 6
-                      + (*captureStats)[pos.movedPiece(*vm)][dstSq(*vm)][pos.captured(*vm)];
+            vm->value = int32_t(PieceValues[MG][captured]) * 6
+                      + (*captureStats)[pos.movedPiece(*vm)][dstSq(*vm)][captured];
         }
-            break;
-        case QUIET: {
-            vm->value = (*mainStats)[pos.activeSide()][mMask(*vm)]
-                      + (*contStats[0])[pos.movedPiece(*vm)][dstSq(*vm)] * 2
-                      + (*contStats[1])[pos.movedPiece(*vm)][dstSq(*vm)]
-                      + (*contStats[3])[pos.movedPiece(*vm)][dstSq(*vm)]
-                      + (*contStats[5])[pos.movedPiece(*vm)][dstSq(*vm)]
-                      + (ply < MAX_LOWPLY ? (*lowPlyStats)[ply][mMask(*vm)] * std::min(depth / 3, 4) : 0);
+    } else
+    if constexpr (GT == QUIET) {
+
+        auto const &butterFlyStats{ (*mainStats)[pos.activeSide()] };
+        auto const &contStats0{ *contStats[0] };
+        auto const &contStats1{ *contStats[1] };
+        auto const &contStats3{ *contStats[3] };
+        auto const &contStats5{ *contStats[5] };
+        // Low-ply stats row & scale, null when beyond low-ply
+        auto const *lowPlyStatsRow{ ply < MAX_LOWPLY ? &(*lowPlyStats)[ply] : nullptr };
+        int32_t const lowPlyScale{ std::min(depth / 3, 4) };
+
+        for (auto vm{ vmBeg }; vm < vmEnd; ++vm) {
+            auto const mpc{ pos.movedPiece(*vm) };
+            auto const dst{ dstSq(*vm) };
+
+            vm->value = butterFlyStats[mMask(*vm)]
+                      + contStats0[mpc][dst] * 2
+                      + contStats1[mpc][dst]
+                      + contStats3[mpc][dst]
+                      + contStats5[mpc][dst]
+                      + (lowPlyStatsRow != nullptr ? (*lowPlyStatsRow)[mMask(*vm)] * lowPlyScale : 0);
         }
-            break;
-        case EVASION: {
+    } else {
+
+        auto const &butterFlyStats{ (*mainStats)[pos.activeSide()] };
+        auto const &contStats0{ *contStats[0] };
+
+        for (auto vm{ vmBeg }; vm < vmEnd; ++vm) {
             if (pos.capture(*vm)) {
                 vm->value = int32_t(PieceValues[MG][pos.captured(*vm)])
                           - pType(pos.movedPiece(*vm));
             } else {
-                vm->value = (*mainStats)[pos.activeSide()][mMask(*vm)]
-                          + (*contStats[0])[pos.movedPiece(*vm)][dstSq(*vm)] * 2
+                vm->value = butterFlyStats[mMask(*vm)]
+                          + contStats0[pos.movedPiece(*vm)][dstSq(*vm)] * 2
                           - 0x10000000; // 1 << 28
             }
         }
-            break;
-        }
     }
 }
 
@@ -317,14 +334,14 @@ Move MovePicker::nextMove() {
     case EVASION_INIT: {
         vmoves.clear();
         vmoves.reserve(32);
-        generate<EVASION>(vmoves, pos);
+        // Evasions are generated legal by construction
+        generate<LEGAL>(vmoves, pos);
         vmBeg = vmoves.begin();
         vmEnd = vmoves.end();
-        vmEnd = std::remove_if(vmBeg, vmEnd,
-                                    [&](ValMove const &vm) {
-                                        return vm == ttMove
-                                            || !pos.pseudoLegal(vm);
-                                    });
+        if (ttMove != MOVE_NONE
+         && vmBeg < vmEnd) {
+            vmEnd = std::remove(vmBeg, vmEnd, ttMove);
+        }
         value<EVASION>();
 
         ++stage;
@@ -1,6 +1,8 @@
 #include "notation.h"
 
+#include <cctype>
 #include <cmath>
+#include <algorithm>
 #include <sstream>
 
 #include "movegenerator.h"
@@ -70,7 +72,7 @@ std::string moveToCAN(Move m) {
     std::ostringstream oss;
     oss << orgSq(m)
         << ((mType(m) != CASTLE
-          || Options["UCI_Chess960"]) ?
+          || Options()["UCI_Chess960"]) ?
             dstSq(m) : kingCastleSq(orgSq(m), dstSq(m)));
     if (mType(m) == PROMOTE) {
         oss << (BLACK|promoteType(m));
@@ -212,64 +214,106 @@ namespace {
         return oss.str();
     }
     */
-}
 
-/// Converts a move to a string in short algebraic notation.
-std::string moveToSAN(Move m, Position &pos) {
-    if (m == MOVE_NONE) return { "(none)" };
-    if (m == MOVE_NULL) return { "(null)" };
-    assert(MoveList<LEGAL>(pos).contains(m));
+    /// Converts a legal move to a string in short algebraic notation, with or without the check marker.
+    std::string sanOf(Move m, Position &pos, bool checkMarker) {
+        std::ostringstream oss;
 
-    std::ostringstream oss;
-    auto const org{ orgSq(m) };
-    auto const dst{ dstSq(m) };
-
-    if (mType(m) != CASTLE) {
-        auto const pt{ pType(pos.pieceOn((org))) };
-        if (pt != PAWN) {
-            oss << (WHITE|pt);
-            if (pt != KING) {
-                // Disambiguation if have more then one piece of type 'pt' that can reach 'dst' with a legal move.
-                auto const amb{ ambiguity(m, pos) };
-                amb == AMB_RANK   ? oss << sFile(org) :
-                amb == AMB_FILE   ? oss << sRank(org) :
-                amb == AMB_SQUARE ? oss << org : oss << "";
+        auto const org{ orgSq(m) };
+        auto const dst{ dstSq(m) };
+
+        if (mType(m) != CASTLE) {
+            auto const pt{ pType(pos.pieceOn((org))) };
+            if (pt != PAWN) {
+                oss << (WHITE|pt);
+                if (pt != KING) {
+                    // Disambiguation if have more then one piece of type 'pt' that can reach 'dst' with a legal move.
+                    auto const amb{ ambiguity(m, pos) };
+                    amb == AMB_RANK   ? oss << sFile(org) :
+                    amb == AMB_FILE   ? oss << sRank(org) :
+                    amb == AMB_SQUARE ? oss << org : oss << "";
+                }
             }
-        }
 
-        if (pos.capture(m)) {
-            if (pt == PAWN) {
-                oss << sFile(org);
+            if (pos.capture(m)) {
+                if (pt == PAWN) {
+                    oss << sFile(org);
+                }
+                oss << "x";
             }
-            oss << "x";
-        }
 
-        oss << dst;
+            oss << dst;
 
-        if (pt == PAWN
-         && mType(m) == PROMOTE) {
-            oss << "=" << (WHITE|promoteType(m));
+            if (pt == PAWN
+             && mType(m) == PROMOTE) {
+                oss << "=" << (WHITE|promoteType(m));
+            }
+        } else {
+            oss << (dst > org ? "O-O" : "O-O-O");
+        }
+
+        // Move marker for check & checkmate
+        if (checkMarker
+         && pos.giveCheck(m)) {
+            StateInfo si;
+            pos.doMove(m, si, true);
+            oss << (MoveList<LEGAL>(pos).size() != 0 ? "+" : "#");
+            pos.undoMove(m);
         }
-    } else {
-        oss << (dst > org ? "O-O" : "O-O-O");
-    }
 
-    // Move marker for check & checkmate
-    if (pos.giveCheck(m)) {
-        StateInfo si;
-        pos.doMove(m, si, true);
-        oss << (MoveList<LEGAL>(pos).size() != 0 ? "+" : "#");
-        pos.undoMove(m);
+        return oss.str();
     }
+}
 
-    return oss.str();
+/// Converts a move to a string in short algebraic notation.
+std::string moveToSAN(Move m, Position &pos) {
+    if (m == MOVE_NONE) return { "(none)" };
+    if (m == MOVE_NULL) return { "(null)" };
+    assert(MoveList<LEGAL>(pos).contains(m));
+
+    return sanOf(m, pos, true);
 }
 /// Converts a string representing a move in short algebraic notation
 /// to the corresponding legal move, if any.
+/// Accepts the PGN variants: annotations (!?), missing check markers, zero castling and promotion without '='.
 Move moveOfSAN(std::string_view san, Position &pos) {
+    std::string str{ san };
+    while (!str.empty()
+        && std::string_view{ "+#!?" }.find(str.back()) != std::string_view::npos) {
+        str.pop_back();
+    }
+    if (str.empty()) {
+        return MOVE_NONE;
+    }
+    if (str[0] == '0') {
+        std::replace(str.begin(), str.end(), '0', 'O');
+    }
+    if (str.size() >= 3
+     && std::isdigit(uint8_t(str[str.size() - 2]))
+     && std::string_view{ "NBRQ" }.find(str.back()) != std::string_view::npos) {
+        str.insert(str.size() - 1, 1, '=');
+    }
+
+    // Only the moves to the destination square are converted to compare
+    bool const castle{ str[0] == 'O' };
+    Square dst{ SQ_NONE };
+    if (!castle) {
+        auto const idx{ str.find_last_of("12345678") };
+        if (idx == std::string::npos
+         || idx == 0
+         || str[idx - 1] < 'a' || str[idx - 1] > 'h') {
+            return MOVE_NONE;
+        }
+        dst = makeSquare(toFile(str[idx - 1]), toRank(str[idx]));
+    }
+
     for (auto const &vm : MoveList<LEGAL>(pos)) {
-        if (moveToSAN(vm, pos) == san) {
-            return vm;
+        if (castle ?
+                mType(vm) == CASTLE :
+                mType(vm) != CASTLE && dstSq(vm) == dst) {
+            if (sanOf(vm, pos, false) == str) {
+                return vm;
+            }
         }
     }
     return MOVE_NONE;
@@ -278,12 +322,12 @@ Move moveOfSAN(std::string_view san, Position &pos) {
 /*
 /// Returns formated human-readable search information.
 std::string prettyInfo(Thread *th) {
-    uint64_t nodes{ Threadpool.accumulate(&Thread::nodes) };
+    uint64_t nodes{ Threadpool().accumulate(&Thread::nodes) };
 
     std::ostringstream oss;
     oss << std::setw( 4) << th->finishedDepth
         << std::setw( 8) << prettyValue(th->rootMoves[0].newValue)
-        << std::setw(12) << prettyTime(TimeMgr.elapsed());
+        << std::setw(12) << prettyTime(TimeMgr().elapsed());
 
     if (nodes < 10ULL*1000) {
         oss << std::setw(8) << uint16_t(nodes);
@@ -1,50 +1,74 @@
 #include "polyglot.h"
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <queue>
 #include <sstream>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
+#include "engine.h"
 #include "movegenerator.h"
 #include "notation.h"
+#include "thread.h"
+#include "uci.h"
+#include "helper/memoryhandler.h"
 #include "helper/prng.h"
-#include "helper/string_view.h"
-
-PolyBook Book;
+#include "helper/string.h"
 
 namespace {
 
+    // Book index samples a key every stride entries, at least one every MinIndexStride,
+    // at most MaxIndexSize keys so it is quick to build and fits in the cache.
+    constexpr uint64_t MinIndexStride{ 16 };
+    constexpr uint64_t MaxIndexSize{ 1 << 16 };
+
+    /// readBE() decodes the big-endian value stored at the data.
     template<typename T>
-    std::ifstream& operator>>(std::ifstream &ifstream, T &t) {
-        t = T();
-        for (uint8_t idx = 0; idx < sizeof(T) && ifstream.good(); ++idx) {
-            t = T((t << 8) + uint8_t(ifstream.get()));
-        }
-        return ifstream;
-    }
-    //template<typename T>
-    //std::ofstream& operator<<(std::ofstream &ofstream, T const &t) {
-    //    for (uint8_t idx = 0; idx < sizeof(T) && ofstream.good(); ++idx) {
-    //        ofstream.put(uint8_t(t >> (8 * (sizeof(T) - 1 - idx))));
-    //    }
-    //    return ofstream;
-    //}
-
-    std::ifstream& operator>>(std::ifstream &ifstream, PolyEntry &pe) {
-        ifstream >> pe.key
-                 >> pe.move
-                 >> pe.weight
-                 >> pe.learn;
-        return ifstream;
-    }
-    //std::ofstream& operator<<(std::ofstream &ofstream, PolyEntry const &pe) {
-    //    ofstream << pe.key
-    //             << pe.move
-    //             << pe.weight
-    //             << pe.learn;
-    //    return ofstream;
-    //}
+    T readBE(uint8_t const *data) noexcept {
+        T t{ 0 };
+        for (uint8_t idx = 0; idx < sizeof(T); ++idx) {
+            t = T((t << 8) + data[idx]);
+        }
+        return t;
+    }
+
+    /// writeBE() encodes the value big-endian into the data.
+    template<typename T>
+    void writeBE(uint8_t *data, T t) noexcept {
+        for (uint8_t idx = 0; idx < sizeof(T); ++idx) {
+            data[sizeof(T) - 1 - idx] = uint8_t(t & 0xFF);
+            t = T(uint64_t(t) >> 8);
+        }
+    }
+
+    /// readEntry() decodes the entry as stored in the book file.
+    PolyEntry readEntry(uint8_t const *data) noexcept {
+        PolyEntry pe;
+        pe.key    = readBE<uint64_t>(data + 0);
+        pe.move   = readBE<uint16_t>(data + 8);
+        pe.weight = readBE<uint16_t>(data + 10);
+        pe.learn  = readBE<uint32_t>(data + 12);
+        return pe;
+    }
+    /// writeEntry() encodes the entry as stored in the book file.
+    void writeEntry(uint8_t *data, PolyEntry const &pe) noexcept {
+        writeBE(data + 0, pe.key);
+        writeBE(data + 8, pe.move);
+        writeBE(data + 10, pe.weight);
+        writeBE(data + 12, pe.learn);
+    }
 
     // Converts polyglot move to engine move
     Move polyMove(Move m, Position const &pos) {
@@ -84,6 +108,82 @@ namespace {
         return dr;
     }
 
+    /// BookSource is one of the books of the "Book File" list, mapped while merging.
+    struct BookSource {
+        std::string    filename;
+        double         weight;  // Multiplier of the weights of the book
+        void const    *baseAddress;
+        uint64_t       mapping;
+        uint8_t const *entryData;
+        uint64_t       entryCount;
+        uint64_t       cursor;  // Next entry to merge
+    };
+
+    /// mergeBooks() merges the sorted books into one sorted book, in the file format.
+    /// Books are in priority order, the same move of a position either sums the weights
+    /// of all the books or, overriding, a position takes the moves of the first book having it.
+    /// Weights are multiplied by the weight of their book and saturate at 16 bits.
+    void mergeBooks(std::vector<BookSource> &sources, bool sumWeights, std::vector<uint8_t> &mergedData) {
+        using Head = std::pair<Key, size_t>;
+        std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+        uint64_t totalCount{ 0 };
+        for (size_t s = 0; s < sources.size(); ++s) {
+            sources[s].cursor = 0;
+            heads.emplace(readBE<uint64_t>(sources[s].entryData), s);
+            totalCount += sources[s].entryCount;
+        }
+        mergedData.clear();
+        mergedData.reserve(totalCount * sizeof(PolyEntry));
+
+        std::vector<size_t> group;
+        std::vector<std::pair<PolyEntry, double>> entries;
+        while (!heads.empty()) {
+            auto const key{ heads.top().first };
+            // Books having the key, in priority order (the heap orders equal keys by source)
+            group.clear();
+            while (!heads.empty()
+                && heads.top().first == key) {
+                group.push_back(heads.top().second);
+                heads.pop();
+            }
+
+            entries.clear();
+            for (auto const s : group) {
+                auto &src{ sources[s] };
+                bool const take{ sumWeights || s == group.front() };
+                for (; src.cursor < src.entryCount; ++src.cursor) {
+                    auto const pe{ readEntry(src.entryData + src.cursor * sizeof(PolyEntry)) };
+                    if (pe.key != key) {
+                        heads.emplace(pe.key, s);
+                        break;
+                    }
+                    if (!take) {
+                        continue;
+                    }
+                    auto itr{ std::find_if(entries.begin(), entries.end(),
+                                [&](auto const &e) { return e.first.move == pe.move; }) };
+                    if (itr == entries.end()) {
+                        entries.emplace_back(pe, 0.0);
+                        itr = entries.end() - 1;
+                    }
+                    itr->second += pe.weight * src.weight;
+                }
+            }
+
+            for (auto &[pe, weight] : entries) {
+                pe.weight = uint16_t(std::min(weight + 0.5, 65535.0));
+            }
+            // Heaviest move first, like the books
+            std::stable_sort(entries.begin(), entries.end(),
+                [](auto const &e1, auto const &e2) { return e1.first.weight > e2.first.weight; });
+            for (auto const &e : entries) {
+                mergedData.resize(mergedData.size() + sizeof(PolyEntry));
+                writeEntry(mergedData.data() + mergedData.size() - sizeof(PolyEntry), e.first);
+            }
+        }
+        mergedData.shrink_to_fit();
+    }
+
 }
 
 bool PolyEntry::operator==(PolyEntry const &pe) const noexcept {
@@ -135,10 +235,15 @@ std::ostream& operator<<(std::ostream &ostream, PolyEntry const &pe) {
 
 /// ----------------
 
-constexpr PolyBook::PolyBook() noexcept :
+PolyBook::PolyBook() noexcept :
     enabled{ false },
-    entryTable{ nullptr },
+    baseAddress{ nullptr },
+    mapping{ 0 },
+    entryData{ nullptr },
     entryCount{ 0 },
+    indexStride{ 0 },
+    indexReady{ false },
+    indexAbort{ false },
     pieces{ 0 },
     failCount{ 0 } {
 }
@@ -150,34 +255,110 @@ PolyBook::~PolyBook() noexcept {
 void PolyBook::clear() noexcept {
 
     enabled = false;
-    if (entryTable != nullptr) {
-        delete[] entryTable;
-        entryTable = nullptr;
+    // Index is built from the book, stop it before the book goes
+    if (indexThread.joinable()) {
+        indexAbort = true;
+        indexThread.join();
+    }
+    indexAbort = false;
+    indexReady = false;
+    if (baseAddress != nullptr) {
+        unmapFile(baseAddress, mapping);
+        baseAddress = nullptr;
     }
+    mergedData.clear();
+    mergedData.shrink_to_fit();
+    entryData = nullptr;
+    entryCount = 0;
+    indexKeys.clear();
+    indexRanks.clear();
+    indexStride = 0;
 }
 
-int64_t PolyBook::findIndex(Key pgKey) const noexcept {
+Key PolyBook::keyAt(uint64_t idx) const noexcept {
+    return readBE<uint64_t>(entryData + idx * sizeof(PolyEntry));
+}
+
+PolyEntry PolyBook::entryAt(uint64_t idx) const noexcept {
+    return readEntry(entryData + idx * sizeof(PolyEntry));
+}
+
+/// PolyBook::startIndex() starts building the index in the background, once per book.
+/// Sampling reads every page of a big book, so it is left to the first probe, not to the loading.
+void PolyBook::startIndex() {
+    if (!indexThread.joinable()
+     && !indexReady.load(std::memory_order::memory_order_acquire)) {
+        indexThread = std::thread{ &PolyBook::buildIndex, this };
+    }
+}
+
+/// PolyBook::buildIndex() samples the keys of the book into the Eytzinger layout,
+/// walking the implicit tree in-order while reading the samples in ascending order.
+/// The index is published only when complete, findIndex() bisects the book until then.
+void PolyBook::buildIndex() noexcept {
+    uint64_t stride{ MinIndexStride };
+    while ((entryCount + stride - 1) / stride > MaxIndexSize) {
+        stride *= 2;
+    }
+    uint64_t const n{ (entryCount + stride - 1) / stride };
+    std::vector<Key> keys(n + 1, 0);
+    std::vector<uint32_t> ranks(n + 1, 0);
+
+    // Leftmost node holds the smallest key
+    uint64_t k{ 1 };
+    while (2 * k <= n) {
+        k = 2 * k;
+    }
+    for (uint64_t r = 0; r < n; ++r) {
+        if (indexAbort.load(std::memory_order::memory_order_relaxed)) {
+            return;
+        }
+        keys[k] = keyAt(r * stride);
+        ranks[k] = uint32_t(r);
+        // Next node in-order
+        if (2 * k + 1 <= n) {
+            k = 2 * k + 1;
+            while (2 * k <= n) {
+                k = 2 * k;
+            }
+        } else {
+            while ((k & 1) != 0) {
+                k >>= 1;
+            }
+            k >>= 1;
+        }
+    }
+
+    indexKeys   = std::move(keys);
+    indexRanks  = std::move(ranks);
+    indexStride = stride;
+    indexReady.store(true, std::memory_order::memory_order_release);
+}
+
+/// PolyBook::bisectIndex() binary-searches the book entries for the first one of the key.
+int64_t PolyBook::bisectIndex(Key pgKey) const noexcept {
     int64_t beg{ 0 };
     int64_t end{ int64_t(entryCount) };
 
     while (beg + 8 < end) {
         int64_t mid{ (beg + end) / 2 };
 
-        if (pgKey > entryTable[mid].key) {
+        auto const key{ keyAt(mid) };
+        if (pgKey > key) {
             beg = mid;
         } else
-        if (pgKey < entryTable[mid].key) {
+        if (pgKey < key) {
             end = mid;
-        } else { // pgKey == entry[mid].key
+        } else { // pgKey == key
             beg = std::max(mid - 4, int64_t(0));
             end = std::min(mid + 4, int64_t(entryCount));
         }
     }
 
     while (beg < end) {
-        if (pgKey == entryTable[beg].key) {
+        if (pgKey == keyAt(beg)) {
             while (beg > 0
-                && pgKey == entryTable[beg - 1].key) {
+                && pgKey == keyAt(beg - 1)) {
                 --beg;
             }
             return beg;
@@ -187,6 +368,46 @@ int64_t PolyBook::findIndex(Key pgKey) const noexcept {
 
     return -1;
 }
+
+/// PolyBook::findIndex() finds the first entry of the key, the index gives the stride
+/// where the first key not less than it lies, then that stride is binary-searched.
+int64_t PolyBook::findIndex(Key pgKey) const noexcept {
+    if (!indexReady.load(std::memory_order::memory_order_acquire)) {
+        return bisectIndex(pgKey);
+    }
+
+    uint64_t const size{ indexKeys.size() };
+    uint64_t k{ 1 };
+    while (k < size) {
+        // Prefetch the keys four levels down
+        if (16 * k < size) {
+            prefetch(&indexKeys[16 * k]);
+        }
+        k = 2 * k + (indexKeys[k] < pgKey);
+    }
+    // Undo the right turns to get the first sample not less than the key (0 if none)
+    k >>= scanLSq(~k) + 1;
+
+    uint64_t beg, end;
+    if (k == 0) {
+        beg = (size - 2) * indexStride + 1;
+        end = entryCount;
+    } else {
+        uint64_t const r{ indexRanks[k] };
+        beg = r != 0 ? (r - 1) * indexStride + 1 : 0;
+        end = r * indexStride + 1;
+    }
+    while (beg < end) {
+        uint64_t const mid{ (beg + end) / 2 };
+        if (keyAt(mid) < pgKey) {
+            beg = mid + 1;
+        } else {
+            end = mid;
+        }
+    }
+    return beg < entryCount
+        && keyAt(beg) == pgKey ? int64_t(beg) : -1;
+}
 //int64_t PolyBook::findIndex(Position const &pos) const noexcept {
 //    return findIndex(pos.pgKey());
 //}
@@ -209,45 +430,63 @@ bool PolyBook::canProbe(Position const &pos) noexcept {
     return failCount <= 4;
 }
 
-void PolyBook::initialize(std::string_view bookFile) {
+/// PolyBook::initialize() loads the books of the list, separated by ';' in priority order,
+/// each optionally followed by '*' and the multiplier of its weights, e.g. "main.bin;side.bin*0.5".
+/// A single book is probed in place, several are merged into one so a probe is a single lookup.
+void PolyBook::initialize(std::string_view bookFiles, bool sumWeights) {
 
     clear();
 
-    std::string filename{ bookFile };
-    std::replace(filename.begin(), filename.end(), '\\', '/');
-    filename = trim(filename);
-    if (filename.empty()) {
-        return;
-    }
+    std::vector<BookSource> sources;
+    for (auto spec : split(bookFiles, ';')) {
+        spec = std::string{ trim(spec) };
+        double weight{ 1.0 };
+        auto const star{ spec.rfind('*') };
+        if (star != std::string::npos) {
+            std::istringstream{ spec.substr(star + 1) } >> weight;
+            spec = std::string{ trim(spec.substr(0, star)) };
+        }
+        std::replace(spec.begin(), spec.end(), '\\', '/');
+        if (spec.empty()
+         || weight <= 0.0) {
+            continue;
+        }
 
-    std::ifstream ifstream{ filename, std::ios::in|std::ios::binary };
-    if (!ifstream.is_open()) {
-        return;
+        // Mapping is O(1), the pages are read on demand and shared with the other processes
+        BookSource src{ spec, weight, nullptr, 0, nullptr, 0, 0 };
+        uint64_t fileSize;
+        src.baseAddress = mapFile(src.filename, fileSize, src.mapping);
+        if (src.baseAddress == nullptr) {
+            continue;
+        }
+        if (fileSize < HeaderSize + sizeof(PolyEntry)) {
+            unmapFile(src.baseAddress, src.mapping);
+            continue;
+        }
+        src.entryData  = static_cast<uint8_t const*>(src.baseAddress) + HeaderSize;
+        src.entryCount = (fileSize - HeaderSize) / sizeof(PolyEntry);
+        ActiveEngine->message("Book entries found " + std::to_string(src.entryCount) + " from file \'" + src.filename + "\'");
+        sources.push_back(src);
     }
-
-    ifstream.seekg(0, std::ios::end);
-    uint64_t const fileSize = ifstream.tellg();
-    ifstream.seekg(0, std::ios::beg);
-
-    entryCount = (fileSize - HeaderSize) / sizeof(PolyEntry);
-    entryTable = new PolyEntry[entryCount];
-    if (entryTable == nullptr) {
+    if (sources.empty()) {
         return;
     }
-    enabled = true;
 
-    if (HeaderSize != 0) {
-        PolyEntry dummy;
-        for (uint64_t idx = 0; idx < HeaderSize / sizeof(PolyEntry); ++idx) {
-            ifstream >> dummy;
+    if (sources.size() == 1) {
+        baseAddress = sources[0].baseAddress;
+        mapping     = sources[0].mapping;
+        entryData   = sources[0].entryData;
+        entryCount  = sources[0].entryCount;
+    } else {
+        mergeBooks(sources, sumWeights, mergedData);
+        for (auto const &src : sources) {
+            unmapFile(src.baseAddress, src.mapping);
         }
+        entryData  = mergedData.data();
+        entryCount = mergedData.size() / sizeof(PolyEntry);
+        ActiveEngine->message("Book entries merged " + std::to_string(entryCount) + " from " + std::to_string(sources.size()) + " files");
     }
-    for (uint64_t idx = 0; idx < entryCount; ++idx) {
-        ifstream >> entryTable[idx];
-    }
-    ifstream.close();
-
-    std::cout << "info string Book entries found " << entryCount << " from file \'" << filename << "\'" << std::endl;
+    enabled = true;
 }
 
 /// PolyBook::probe() tries to find a book move for the given position.
@@ -259,13 +498,15 @@ Move PolyBook::probe(Position &pos, int16_t moveCount, bool pickBest) {
     static PRNG prng(now());
 
     if (!enabled
-     || entryTable == nullptr
+     || entryData == nullptr
      || (moveCount != 0
       && moveCount < pos.moveCount())
      || !canProbe(pos)) {
         return MOVE_NONE;
     }
 
+    startIndex();
+
     auto const pgKey{ pos.pgKey() };
     auto const index{ findIndex(pgKey) };
     if (index < 0) {
@@ -279,34 +520,35 @@ Move PolyBook::probe(Position &pos, int16_t moveCount, bool pickBest) {
 
     uint64_t pick1Index = index;
     uint64_t idx = index;
-    while (idx < entryCount
-        && pgKey == entryTable[idx].key) {
-
-        if (entryTable[idx].move == MOVE_NONE) {
+    for (; idx < entryCount; ++idx) {
+        auto const pe{ entryAt(idx) };
+        if (pgKey != pe.key) {
+            break;
+        }
+        if (pe.move == MOVE_NONE) {
             continue;
         }
         ++count;
-        maxWeight = std::max(entryTable[idx].weight, maxWeight);
-        sumWeight += entryTable[idx].weight;
+        maxWeight = std::max(pe.weight, maxWeight);
+        sumWeight += pe.weight;
 
         // Choose the move
         if (pickBest) {
-            if (maxWeight == entryTable[idx].weight) {
+            if (maxWeight == pe.weight) {
                 pick1Index = idx;
             }
         } else {
             // Move with a very high score, has a higher probability of being choosen.
             if (sumWeight != 0
-             && (prng.rand<uint32_t>() % sumWeight) < entryTable[idx].weight) {
+             && (prng.rand<uint32_t>() % sumWeight) < pe.weight) {
                 pick1Index = idx;
             }
         }
-        ++idx;
     }
 
     Move move;
 
-    move = Move(entryTable[pick1Index].move);
+    move = Move(entryAt(pick1Index).move);
     if (move == MOVE_NONE) {
         return MOVE_NONE;
     }
@@ -330,7 +572,7 @@ Move PolyBook::probe(Position &pos, int16_t moveCount, bool pickBest) {
         assert(pick2Index < idx);
     }
 
-    move = Move(entryTable[pick2Index].move);
+    move = Move(entryAt(pick2Index).move);
     if (move == MOVE_NONE) {
         return MOVE_NONE;
     }
@@ -345,7 +587,7 @@ Move PolyBook::probe(Position &pos, int16_t moveCount, bool pickBest) {
 }
 
 std::string PolyBook::show(Position const &pos) const {
-    if (entryTable == nullptr
+    if (entryData == nullptr
      || !enabled) {
         return "Book entries empty.";
     }
@@ -358,11 +600,13 @@ std::string PolyBook::show(Position const &pos) const {
 
     std::vector<PolyEntry> peSet;
     uint32_t sumWeight{ 0 };
-    while (uint64_t(index) < entryCount
-        && key == entryTable[index].key) {
-        peSet.push_back(entryTable[index]);
-        sumWeight += entryTable[index].weight;
-        ++index;
+    for (; uint64_t(index) < entryCount; ++index) {
+        auto const pe{ entryAt(index) };
+        if (key != pe.key) {
+            break;
+        }
+        peSet.push_back(pe);
+        sumWeight += pe.weight;
     }
 
     if (peSet.empty()) {
@@ -386,3 +630,523 @@ std::string PolyBook::show(Position const &pos) const {
     return oss.str();
 
 }
+
+/// PolyBook::benchProbe() is a micro-benchmark of the book lookup, with and without the index.
+/// Looks up the given number of keys, half of them in the book and half random.
+void PolyBook::benchProbe(uint32_t count) {
+    if (entryData == nullptr) {
+        std::cout << "Book entries empty." << std::endl;
+        return;
+    }
+    // Wait for the index to compare with
+    startIndex();
+    if (indexThread.joinable()) {
+        indexThread.join();
+    }
+
+    constexpr uint32_t KeyCount{ 0x10000 };
+    PRNG prng(0x1FD3E2A);
+    std::vector<Key> keys(KeyCount);
+    for (uint32_t i = 0; i < KeyCount; ++i) {
+        keys[i] = (i & 1) != 0 ?
+                    keyAt(prng.rand<uint64_t>() % entryCount) :
+                    prng.rand<Key>();
+    }
+
+    std::pair<char const*, int64_t(PolyBook::*)(Key) const noexcept> const finders[]{
+        { "bisect", &PolyBook::bisectIndex },
+        { "index",  &PolyBook::findIndex }
+    };
+    for (auto const &finder : finders) {
+        // Warm up the pages of the book
+        for (auto const key : keys) {
+            (this->*finder.second)(key);
+        }
+
+        uint32_t found{ 0 };
+        auto const start{ std::chrono::steady_clock::now() };
+        for (uint32_t i = 0; i < count; ++i) {
+            found += (this->*finder.second)(keys[i % KeyCount]) >= 0;
+        }
+        auto const elapsed{ std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count() };
+
+        std::cout << std::left << std::setw(6) << finder.first
+                  << " ns/probe: " << std::right << std::setw(6) << elapsed / std::max(count, 1U)
+                  << " found: " << found << '\n';
+    }
+    std::cout << "Book entries: " << entryCount
+              << " index keys: " << indexKeys.size() - 1
+              << " stride: " << indexStride << std::endl;
+}
+
+namespace {
+
+    /// toPolyMove() converts the engine move to the Polyglot move encoding, the reverse of polyMove().
+    uint16_t toPolyMove(Move m) noexcept {
+        return mType(m) == PROMOTE ?
+                uint16_t(((promoteType(m) - NIHT + 1) << 12) + mMask(m)) :
+                mMask(m);
+    }
+
+    /// BookStat is the statistics of a move in a position, gathered from the games.
+    struct BookStat {
+
+        bool operator<(BookStat const &bs) const noexcept {
+            return key != bs.key ? key < bs.key : move < bs.move;
+        }
+        bool operator>(BookStat const &bs) const noexcept {
+            return bs < *this;
+        }
+
+        Key      key;
+        uint16_t move;
+        uint32_t score; // Half points of the side playing the move: win 2, draw 1
+        uint32_t count; // Games playing the move
+    };
+
+    struct BookStatHash {
+        size_t operator()(std::pair<Key, uint16_t> const &km) const noexcept {
+            return size_t(km.first ^ (km.second * U64(0x9E3779B97F4A7C15)));
+        }
+    };
+
+    using BookStatMap = std::unordered_map<std::pair<Key, uint16_t>, std::pair<uint32_t, uint32_t>, BookStatHash>;
+
+    // Approximate memory of an entry of the map, to bound the memory of the workers
+    constexpr size_t BookStatNodeSize{ 64 };
+    // Runs merged at once, more runs are merged in several passes
+    constexpr size_t MaxMergeRuns{ 64 };
+
+    /// RunReader reads back a sorted run of book statistics, buffered.
+    class RunReader {
+
+    public:
+
+        explicit RunReader(std::string const &runFile) :
+            ifstream{ runFile, std::ios::in|std::ios::binary },
+            buffer(0x1000),
+            count{ 0 },
+            index{ 0 } {
+        }
+
+        bool next(BookStat &bs) {
+            if (index == count) {
+                ifstream.read(reinterpret_cast<char*>(buffer.data()), buffer.size() * sizeof(BookStat));
+                count = size_t(ifstream.gcount()) / sizeof(BookStat);
+                index = 0;
+                if (count == 0) {
+                    return false;
+                }
+            }
+            bs = buffer[index++];
+            return true;
+        }
+
+    private:
+
+        std::ifstream ifstream;
+        std::vector<BookStat> buffer;
+        size_t count;
+        size_t index;
+    };
+
+    /// writeRun() sorts the statistics of the map and writes them to the run file.
+    void writeRun(BookStatMap const &statMap, std::string const &runFile) {
+        std::vector<BookStat> stats;
+        stats.reserve(statMap.size());
+        for (auto const &[km, sc] : statMap) {
+            stats.push_back({ km.first, km.second, sc.first, sc.second });
+        }
+        std::sort(stats.begin(), stats.end());
+
+        std::ofstream ofstream{ runFile, std::ios::out|std::ios::binary|std::ios::trunc };
+        ofstream.write(reinterpret_cast<char const*>(stats.data()), stats.size() * sizeof(BookStat));
+    }
+
+    /// mergeRuns() merges the sorted runs, summing the same move of the same position,
+    /// and passes each move once in order to the sink.
+    template<typename Sink>
+    void mergeRuns(std::vector<std::string> const &runFiles, Sink sink) {
+        std::vector<std::unique_ptr<RunReader>> readers;
+        using Head = std::pair<BookStat, size_t>;
+        auto const greater{ [](Head const &h1, Head const &h2) { return h1.first > h2.first; } };
+        std::priority_queue<Head, std::vector<Head>, decltype(greater)> heads{ greater };
+
+        for (auto const &runFile : runFiles) {
+            readers.emplace_back(new RunReader{ runFile });
+            BookStat bs;
+            if (readers.back()->next(bs)) {
+                heads.emplace(bs, readers.size() - 1);
+            }
+        }
+
+        bool merged{ false };
+        BookStat sum{};
+        while (!heads.empty()) {
+            auto const [bs, r] = heads.top();
+            heads.pop();
+
+            if (merged
+             && sum.key == bs.key
+             && sum.move == bs.move) {
+                sum.score += bs.score;
+                sum.count += bs.count;
+            } else {
+                if (merged) {
+                    sink(sum);
+                }
+                sum = bs;
+                merged = true;
+            }
+
+            BookStat nbs;
+            if (readers[r]->next(nbs)) {
+                heads.emplace(nbs, r);
+            }
+        }
+        if (merged) {
+            sink(sum);
+        }
+    }
+
+    /// replayGame() replays the moves of the PGN game up to the max ply,
+    /// then passes each position key, move played and its score to the recorder.
+    /// Returns false if the game is skipped: no result, unsupported variant or illegal move,
+    /// nothing of a skipped game is recorded.
+    template<typename Recorder>
+    bool replayGame(std::string const &game, Position &pos, StateList &states, Thread *th, int16_t maxPly, Recorder record) {
+        std::string fen{ UCI::StartFEN };
+        std::string result;
+        std::string moveText;
+
+        std::istringstream iss{ game };
+        std::string line;
+        while (std::getline(iss, line, '\n')) {
+            if (!line.empty()
+             && line[0] == '[') {
+                auto const beg{ line.find('"') };
+                auto const end{ line.rfind('"') };
+                if (beg == std::string::npos
+                 || end <= beg) {
+                    continue;
+                }
+                auto const name{ line.substr(1, line.find_first_of(" \t") - 1) };
+                auto const value{ line.substr(beg + 1, end - beg - 1) };
+                if (name == "FEN") {
+                    fen = value;
+                } else
+                if (name == "Result") {
+                    result = value;
+                } else
+                if (name == "Variant"
+                 && toLower(value) != "standard") {
+                    return false;
+                }
+            } else {
+                moveText += line;
+                moveText += '\n';
+            }
+        }
+
+        // Remove the comments (braced and to the end of line), variations and NAGs
+        std::string moves;
+        int16_t depth{ 0 };
+        for (size_t i = 0; i < moveText.size(); ++i) {
+            auto const c{ moveText[i] };
+            if (c == '{') {
+                i = std::min(moveText.find('}', i), moveText.size());
+            } else
+            if (c == ';') {
+                i = std::min(moveText.find('\n', i), moveText.size());
+                moves += ' ';
+            } else
+            if (c == '(') {
+                ++depth;
+            } else
+            if (c == ')') {
+                depth = std::max(depth - 1, 0);
+            } else
+            if (depth == 0) {
+                if (c == '$') {
+                    while (i + 1 < moveText.size()
+                        && std::isdigit(uint8_t(moveText[i + 1]))) {
+                        ++i;
+                    }
+                } else {
+                    moves += c;
+                }
+            }
+        }
+
+        std::istringstream movesIss{ moves };
+        std::vector<std::string> sans;
+        std::string token;
+        while (movesIss >> token) {
+            if (token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*") {
+                if (result.empty()) {
+                    result = token;
+                }
+                break;
+            }
+            // Strip the move number ("10." or "10..."), moveOfSAN() reads the castling written with zeros
+            auto const digits{ token.find_first_not_of("0123456789") };
+            if (digits != 0
+             && digits != std::string::npos
+             && token[digits] == '.') {
+                token.erase(0, token.find_first_not_of('.', digits));
+            }
+            if (!token.empty()) {
+                sans.push_back(token);
+            }
+        }
+
+        uint32_t const whiteScore{
+            result == "1-0"     ? 2U :
+            result == "1/2-1/2" ? 1U :
+            result == "0-1"     ? 0U : 3U };
+        if (whiteScore > 2) {
+            return false;
+        }
+
+        states.clear();
+        states.emplace_back();
+        pos.setup(fen, states.back(), th);
+
+        std::vector<BookStat> plies;
+        plies.reserve(std::min(size_t(std::max(maxPly, int16_t(0))), sans.size()));
+        for (int16_t ply = 0; ply < maxPly && ply < int16_t(sans.size()); ++ply) {
+            auto const m{ moveOfSAN(sans[ply], pos) };
+            if (m == MOVE_NONE) {
+                return false;
+            }
+            plies.push_back({ pos.pgKey(), toPolyMove(m), pos.activeSide() == WHITE ? whiteScore : 2 - whiteScore, 1 });
+            states.emplace_back();
+            pos.doMove(m, states.back());
+        }
+        for (auto const &bs : plies) {
+            record(bs.key, bs.move, bs.score);
+        }
+        return true;
+    }
+}
+
+/// makeBook() builds a Polyglot book from the games of the PGN files.
+/// The caller reads and splits the files into games, the workers replay them with moveOfSAN()/doMove()
+/// and count the moves of the first plies in their own hash map, a shard needing no lock.
+/// A full map is sorted and spilled to a run file so the memory stays bounded,
+/// at the end the runs are merged (external sort) into the book.
+/// Weight of a move is its half points (win 2, draw 1), scaled down if above 16 bits.
+/// Returns false if the book can not be written, the run files are then kept.
+bool makeBook(std::vector<std::string> const &pgnFiles, std::string const &bookFile,
+              uint16_t workerCount, int16_t maxPly, uint32_t minGames, uint32_t memoryMB) {
+
+    auto *const engine{ ActiveEngine };
+    size_t const maxMapSize{ std::max(size_t(memoryMB) * 1024 * 1024 / workerCount / BookStatNodeSize, size_t(0x1000)) };
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<std::string> games;
+    bool readDone{ false };
+    size_t const maxQueueSize{ size_t(workerCount) * 0x100 };
+
+    std::vector<std::string> runFiles;
+    std::atomic<uint64_t> gameCount{ 0 };
+    std::atomic<uint64_t> skipCount{ 0 };
+    std::atomic<uint64_t> moveCount{ 0 };
+
+    TimePoint elapsed{ now() };
+
+    std::vector<std::thread> threads;
+    for (uint16_t w = 0; w < workerCount; ++w) {
+        threads.emplace_back(
+            [&, w]() {
+                EngineScope engineScope{ engine };
+                // Position needs a thread for its tables, the search threads are idle
+                auto *const th{ Threadpool()[w % Threadpool().size()] };
+
+                Position pos;
+                StateList states;
+                BookStatMap statMap;
+                statMap.reserve(maxMapSize);
+
+                auto const spill{ [&]() {
+                    std::string runFile;
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        runFile = bookFile + ".run" + std::to_string(runFiles.size());
+                        runFiles.push_back(runFile);
+                    }
+                    writeRun(statMap, runFile);
+                    statMap.clear();
+                } };
+
+                std::string game;
+                while (true) {
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        condition.wait(lock, [&]() { return !games.empty() || readDone; });
+                        if (games.empty()) {
+                            break;
+                        }
+                        game = std::move(games.front());
+                        games.pop_front();
+                    }
+                    condition.notify_all();
+
+                    bool const replayed{ replayGame(game, pos, states, th, maxPly,
+                        [&](Key key, uint16_t move, uint32_t score) {
+                            auto &sc{ statMap[{ key, move }] };
+                            sc.first += score;
+                            sc.second += 1;
+                            moveCount.fetch_add(1, std::memory_order::memory_order_relaxed);
+                        }) };
+                    (replayed ? gameCount : skipCount).fetch_add(1, std::memory_order::memory_order_relaxed);
+
+                    if (statMap.size() >= maxMapSize) {
+                        spill();
+                    }
+                }
+                if (!statMap.empty()) {
+                    spill();
+                }
+            });
+    }
+
+    // Split the files into games, a game starts at a tag line following its move text
+    for (auto const &pgnFile : pgnFiles) {
+        std::ifstream ifstream{ pgnFile, std::ios::in };
+        if (!ifstream.is_open()) {
+            std::cerr << "ERROR: unable to open file ... \'" << pgnFile << "\'\n";
+            continue;
+        }
+
+        std::string game;
+        bool moveText{ false };
+        auto const push{ [&]() {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [&]() { return games.size() < maxQueueSize; });
+            games.push_back(std::move(game));
+            lock.unlock();
+            condition.notify_all();
+            game.clear();
+            moveText = false;
+        } };
+
+        std::string line;
+        while (std::getline(ifstream, line, '\n')) {
+            if (!line.empty()
+             && line.back() == '\r') {
+                line.pop_back();
+            }
+            if (whiteSpaces(line)) {
+                continue;
+            }
+            if (line[0] == '[') {
+                if (moveText) {
+                    push();
+                }
+            } else {
+                moveText = true;
+            }
+            game += line;
+            game += '\n';
+        }
+        if (moveText) {
+            push();
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        readDone = true;
+    }
+    condition.notify_all();
+
+    for (auto &th : threads) {
+        th.join();
+    }
+
+    // Merge the runs in passes of at most MaxMergeRuns
+    auto runCount{ runFiles.size() };
+    while (runFiles.size() > MaxMergeRuns) {
+        std::vector<std::string> mergedFiles;
+        for (size_t i = 0; i < runFiles.size(); i += MaxMergeRuns) {
+            std::vector<std::string> const passFiles(
+                runFiles.begin() + i,
+                runFiles.begin() + std::min(i + MaxMergeRuns, runFiles.size()));
+
+            auto const runFile{ bookFile + ".run" + std::to_string(runCount++) };
+            std::ofstream ofstream{ runFile, std::ios::out|std::ios::binary|std::ios::trunc };
+            mergeRuns(passFiles, [&](BookStat const &bs) {
+                ofstream.write(reinterpret_cast<char const*>(&bs), sizeof(bs));
+            });
+            for (auto const &passFile : passFiles) {
+                std::remove(passFile.c_str());
+            }
+            mergedFiles.push_back(runFile);
+        }
+        runFiles = std::move(mergedFiles);
+    }
+
+    std::ofstream ofstream{ bookFile, std::ios::out|std::ios::binary|std::ios::trunc };
+    if (!ofstream.is_open()) {
+        std::cerr << "ERROR: unable to open file ... \'" << bookFile << "\', runs kept in \'" << bookFile << ".run*\'\n";
+        return false;
+    }
+
+    uint64_t positionCount{ 0 };
+    uint64_t entryCount{ 0 };
+    std::vector<BookStat> group;
+    auto const flush{ [&]() {
+        auto const maxScore{ std::accumulate(group.begin(), group.end(), uint32_t(0),
+                                [](uint32_t s, BookStat const &bs) { return std::max(s, bs.score); }) };
+        std::vector<PolyEntry> entries;
+        for (auto const &bs : group) {
+            uint16_t const weight(maxScore > 0xFFFF ? uint64_t(bs.score) * 0xFFFF / maxScore : bs.score);
+            if (weight != 0) {
+                entries.push_back({ bs.key, bs.move, weight, 0 });
+            }
+        }
+        // Heaviest move first
+        std::sort(entries.begin(), entries.end(), std::greater<PolyEntry>());
+        for (auto const &pe : entries) {
+            uint8_t data[sizeof(PolyEntry)];
+            writeEntry(data, pe);
+            ofstream.write(reinterpret_cast<char const*>(data), sizeof(data));
+        }
+        positionCount += !entries.empty();
+        entryCount += entries.size();
+        group.clear();
+    } };
+    mergeRuns(runFiles, [&](BookStat const &bs) {
+        if (!group.empty()
+         && group.back().key != bs.key) {
+            flush();
+        }
+        if (bs.count >= minGames) {
+            group.push_back(bs);
+        }
+    });
+    flush();
+    ofstream.close();
+
+    for (auto const &runFile : runFiles) {
+        std::remove(runFile.c_str());
+    }
+
+    elapsed = std::max(now() - elapsed, { 1 });
+
+    std::ostringstream oss;
+    oss << std::right
+        << "\n=================================\n"
+        << "Games           :" << std::setw(16) << gameCount << '\n'
+        << "Games skipped   :" << std::setw(16) << skipCount << '\n'
+        << "Moves           :" << std::setw(16) << moveCount << '\n'
+        << "Runs            :" << std::setw(16) << runCount << '\n'
+        << "Positions       :" << std::setw(16) << positionCount << '\n'
+        << "Book entries    :" << std::setw(16) << entryCount << '\n'
+        << "Total time (ms) :" << std::setw(16) << elapsed << '\n'
+        << "Games/second    :" << std::setw(16) << (gameCount + skipCount) * 1000 / elapsed << '\n'
+        << "---------------------------------\n";
+    std::cerr << oss.str() << '\n';
+    return true;
+}
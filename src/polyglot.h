@@ -1,6 +1,10 @@
 #pragma once
 
+#include <atomic>
+#include <string>
 #include <string_view>
+#include <thread>
+#include <vector>
 
 #include "position.h"
 #include "type.h"
@@ -41,15 +45,17 @@ extern std::ostream& operator<<(std::ostream&, PolyEntry const&);
 class PolyBook {
 
 public:
-    constexpr PolyBook() noexcept;
+    PolyBook() noexcept;
     ~PolyBook() noexcept;
 
-    void initialize(std::string_view);
+    void initialize(std::string_view, bool);
 
     Move probe(Position&, int16_t, bool);
 
     std::string show(Position const&) const;
 
+    void benchProbe(uint32_t);
+
     static constexpr uint64_t HeaderSize{ 0 * sizeof(PolyEntry) };
 
     bool enabled;
@@ -57,19 +63,45 @@ public:
 private:
     void clear() noexcept;
 
+    Key       keyAt(uint64_t) const noexcept;
+    PolyEntry entryAt(uint64_t) const noexcept;
+
+    void startIndex();
+    void buildIndex() noexcept;
+
+    int64_t bisectIndex(Key) const noexcept;
     int64_t findIndex(Key) const noexcept;
     //int64_t findIndex(Position const&) const noexcept;
     //int64_t findIndex(std::string_view) const noexcept;
 
     bool canProbe(Position const&) noexcept;
 
-    PolyEntry *entryTable;
-    uint64_t   entryCount;
+    // Book file is memory mapped, the big-endian entries are decoded on access
+    void const    *baseAddress;
+    uint64_t       mapping;
+    uint8_t const *entryData;
+    uint64_t       entryCount;
+    // Entries of several books merged, in the file format
+    std::vector<uint8_t> mergedData;
+
+    // Keys sampled every indexStride entries in Eytzinger layout (1-based, breadth-first),
+    // with their ranks, to narrow the search to one stride before touching the book.
+    // Built in the background from the first probe, the book is bisected until it is ready.
+    std::vector<Key>      indexKeys;
+    std::vector<uint32_t> indexRanks;
+    uint64_t              indexStride;
+    std::thread           indexThread;
+    std::atomic<bool>     indexReady;
+    std::atomic<bool>     indexAbort;
 
     // Last probe info
     Bitboard pieces;
     uint8_t  failCount;
 };
 
-// Global Polyglot Book
-extern PolyBook Book;
+// Polyglot Book of the active engine
+extern PolyBook& Book() noexcept;
+
+// Builds the book from the games of the PGN files: worker threads, max ply, min games of a move, memory in MB.
+// Returns false if the book can not be written.
+extern bool makeBook(std::vector<std::string> const&, std::string const&, uint16_t, int16_t, uint32_t, uint32_t);
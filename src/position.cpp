@@ -98,7 +98,7 @@ Key Position::movePosiKey(Move m) const noexcept {
 bool Position::draw(int16_t pp) const noexcept {
     return  // Draw by Clock Ply Rule?
             // Not in check or in check have legal moves
-           (_stateInfo->clockPly >= 2 * int16_t(Options["Draw MoveCount"])
+           (_stateInfo->clockPly >= 2 * int16_t(Options()["Draw MoveCount"])
          && (_stateInfo->checkers == 0
           || MoveList<LEGAL>(*this).size() != 0))
             // Draw by Repetition?
@@ -324,7 +324,7 @@ bool Position::legal(Move m) const noexcept {
         }
         //// In case of Chess960, verify that when moving the castling rook we do not discover some hidden checker.
         //// For instance an enemy queen in SQ_A1 when castling rook is in SQ_B1.
-        //return !Options["UCI_Chess960"]
+        //return !Options()["UCI_Chess960"]
         //    || !isKingBlockersOn(active, dst);
         return true;
     }
@@ -1142,7 +1142,7 @@ void Position::doNullMove(StateInfo &si) noexcept {
     active = ~active;
     _stateInfo->posiKey ^= RandZob.side;
 
-    prefetch(TT.cluster(posiKey())->entry);
+    prefetch(TT().cluster(posiKey())->entry);
     setCheckInfo();
 
     _stateInfo->repetition = 0;
@@ -1216,7 +1216,7 @@ void Position::mirror() {
     iss >> token;
     if (token != "-") {
         for (auto &ch : token) {
-            if (Options["UCI_Chess960"]) {
+            if (Options()["UCI_Chess960"]) {
                 assert(isalpha(ch));
                 ch = toChar(~toFile(char(tolower(ch))), islower(ch));
             } else {
@@ -1275,10 +1275,10 @@ std::string Position::fen(bool full) const {
     oss << ' ' << active << ' ';
 
     if (_stateInfo->castleRights != CR_NONE) {
-        if (canCastle(WHITE, CS_KING)) { oss << (Options["UCI_Chess960"] ? toChar(sFile(castleRookSq(WHITE, CS_KING)), false) : 'K'); }
-        if (canCastle(WHITE, CS_QUEN)) { oss << (Options["UCI_Chess960"] ? toChar(sFile(castleRookSq(WHITE, CS_QUEN)), false) : 'Q'); }
-        if (canCastle(BLACK, CS_KING)) { oss << (Options["UCI_Chess960"] ? toChar(sFile(castleRookSq(BLACK, CS_KING)),  true) : 'k'); }
-        if (canCastle(BLACK, CS_QUEN)) { oss << (Options["UCI_Chess960"] ? toChar(sFile(castleRookSq(BLACK, CS_QUEN)),  true) : 'q'); }
+        if (canCastle(WHITE, CS_KING)) { oss << (Options()["UCI_Chess960"] ? toChar(sFile(castleRookSq(WHITE, CS_KING)), false) : 'K'); }
+        if (canCastle(WHITE, CS_QUEN)) { oss << (Options()["UCI_Chess960"] ? toChar(sFile(castleRookSq(WHITE, CS_QUEN)), false) : 'Q'); }
+        if (canCastle(BLACK, CS_KING)) { oss << (Options()["UCI_Chess960"] ? toChar(sFile(castleRookSq(BLACK, CS_KING)),  true) : 'k'); }
+        if (canCastle(BLACK, CS_QUEN)) { oss << (Options()["UCI_Chess960"] ? toChar(sFile(castleRookSq(BLACK, CS_QUEN)),  true) : 'q'); }
     } else {
         oss << '-';
     }
@@ -1313,8 +1313,8 @@ std::string Position::toString() const {
     for (Bitboard b = _stateInfo->checkers; b != 0; ) {
         oss << popLSq(b) << ' ';
     }
-    if (Book.enabled) {
-        oss << '\n' << Book.show(*this);
+    if (Book().enabled) {
+        oss << '\n' << Book().show(*this);
     }
     if (count() <= SyzygyTB::MaxPieceLimit
      && _stateInfo->castleRights == CR_NONE) {
@@ -1446,7 +1446,7 @@ bool Position::ok() const noexcept {
      || _stateInfo->posiKey != RandZob.computePosiKey(*this)
      || _stateInfo->checkers != (attackersTo(square(active|KING)) & pieces(~active))
      || popCount(_stateInfo->checkers) > 2
-     || _stateInfo->clockPly > 2 * int16_t(Options["Draw MoveCount"])
+     || _stateInfo->clockPly > 2 * int16_t(Options()["Draw MoveCount"])
      || (_stateInfo->captured != NONE
       && _stateInfo->clockPly != 0)
      || (_stateInfo->epSquare != SQ_NONE
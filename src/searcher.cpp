@@ -5,8 +5,8 @@
 #include <cmath>
 #include <algorithm>
 #include <iostream>
-#include <sstream>
 
+#include "engine.h"
 #include "evaluator.h"
 #include "movegenerator.h"
 #include "movepicker.h"
@@ -27,16 +27,6 @@
 
 using Evaluator::evaluate;
 
-Limit Limits;
-
-namespace SyzygyTB {
-
-    Depth   DepthLimit;
-    int16_t PieceLimit;
-    bool    Move50Rule;
-    bool    HasRoot;
-}
-
 namespace {
 
     /// Stack keeps the information of the nodes in the tree during the search.
@@ -65,11 +55,10 @@ namespace {
         return Value(234 * (d - imp));
     }
 
-    constexpr int32_t MAX_MOVES{ 256 };
-    int32_t Reduction[MAX_MOVES];
     inline Depth reduction(Depth d, uint16_t mc, bool imp) noexcept {
         assert(d >= DEPTH_ZERO);
-        auto const r{ Reduction[d] * Reduction[mc] };
+        auto const *reductions{ Threadpool().reductions };
+        auto const r{ reductions[d] * reductions[mc] };
         return Depth( (r + 503) / 1024 + (!imp && (r > 915)) );
     }
 
@@ -117,6 +106,23 @@ namespace {
         return depth <= 14 ? (6 * depth + 231) * depth - 206 : 66;
     }
 
+    /// probeTT() looks up the position in the hash,
+    /// in the deterministic search through the entries buffered by the thread.
+    TEntry* probeTT(Thread *th, Key posiKey, bool &ttHit) noexcept {
+        return Threadpool().deterministic ?
+                th->ttBuffer.probe(posiKey, ttHit) :
+                TT().probe(posiKey, ttHit);
+    }
+    /// saveEntry() returns the entry to save the position after searching the moves,
+    /// in the deterministic search the buffer may have been flushed at a sync point meanwhile.
+    TEntry* saveEntry(Thread *th, Key posiKey, TEntry *tte) noexcept {
+        if (Threadpool().deterministic) {
+            bool ttHit;
+            tte = th->ttBuffer.probe(posiKey, ttHit);
+        }
+        return tte;
+    }
+
     /// Add a small random component to draw evaluations to avoid 3-fold-blindness
     Value drawValue(Thread const* th) noexcept {
         return VALUE_DRAW + int32_t(2 * (th->nodes & 1) - 1);
@@ -203,30 +209,35 @@ namespace {
         return int16_t( 0.5 + 1000 / (1 + std::exp((a - x) / b)) );
     }
 
-    /// wdl() report WDL statistics given an evaluation and a game ply, based on
-    /// data gathered for fishtest LTC games.
-    std::string wdl(Value v, int16_t ply) {
-        std::ostringstream oss;
-
-        int16_t const wdl_w( winRateModel(+v, ply) );
-        int16_t const wdl_l( winRateModel(-v, ply) );
-        int16_t const wdl_d( 1000 - wdl_w - wdl_l );
-        oss << " wdl " << wdl_w << " " << wdl_d << " " << wdl_l;
-        return oss.str();
-    }
-
-    /// multipvInfo() formats PV information according to UCI protocol.
+    /// multipvInfo() sends the information of all the PV lines to the info listener of the engine.
     /// UCI requires that all (if any) un-searched PV lines are sent using a previous search score.
-    std::string multipvInfo(Thread const *th, Depth depth, Value alfa, Value beta) {
-        TimePoint const elapsed{ std::max(TimeMgr.elapsed(), { 1 }) };
-        auto const nodes{ Threadpool.accumulate(&Thread::nodes) };
-        auto const tbHits{ Threadpool.accumulate(&Thread::tbHits)
-                         + th->rootMoves.size() * SyzygyTB::HasRoot };
-
-        std::ostringstream oss;
-        for (uint16_t i = 0; i < Threadpool.pvCount; ++i) {
+    void multipvInfo(Thread const *th, Depth depth, Value alfa, Value beta) {
+        if (!ActiveEngine->onInfo) {
+            return;
+        }
 
-            bool const updated{ th->rootMoves[i].newValue != -VALUE_INFINITE };
+        TimePoint const elapsed{ std::max(TimeMgr().elapsed(), { 1 }) };
+        // Deterministic search counts the nodes of the other threads as at the last sync point
+        auto const nodes{ Threadpool().deterministic ?
+                            Threadpool().syncedNodes + th->nodes - th->syncedNodes :
+                            Threadpool().accumulate(&Thread::nodes) };
+        auto const tbHits{ Threadpool().accumulate(&Thread::tbHits)
+                         + th->rootMoves.size() * Threadpool().tbHasRoot };
+        auto const hashFull{ int16_t(elapsed > 1000 ? TT().hashFull() : -1) };
+
+        // Split MultiPV search sends the lines merged from all the groups, each at the depth finished by its group
+        bool const merged{ Threadpool().pvGroups > 1 };
+        std::vector<Depth> depths;
+        RootMoves const lines{ merged ? Threadpool().mergedLines(depths) : RootMoves{} };
+        auto const &rootMoves{ merged ? lines : th->rootMoves };
+        auto const pvCount{ merged ? uint16_t(lines.size()) : th->pvCount };
+
+        for (uint16_t i = 0; i < pvCount; ++i) {
+
+            bool const updated{
+                merged ?
+                    depths[i] != DEPTH_ZERO :
+                    rootMoves[i].newValue != -VALUE_INFINITE };
 
             if (depth == 1
              && !updated
@@ -234,47 +245,41 @@ namespace {
                 continue;
             }
 
-            auto d{ updated ? depth : std::max(depth - 1, 1) };
-            auto v{ updated ? th->rootMoves[i].newValue : th->rootMoves[i].oldValue };
+            auto d{ updated ? merged ? depths[i] : depth : std::max(depth - 1, 1) };
+            auto v{ updated ? rootMoves[i].newValue : rootMoves[i].oldValue };
 
             if (v == -VALUE_INFINITE) {
                 v = VALUE_ZERO;
             }
 
             bool const tb{
-                SyzygyTB::HasRoot
+                Threadpool().tbHasRoot
              && std::abs(v) < VALUE_MATE_1_MAX_PLY };
             if (tb) {
-                v = th->rootMoves[i].tbValue;
-            }
-
-            oss << std::setfill('0')
-                << "info"
-                << " depth "    << std::setw(2) << d
-                << " seldepth " << std::setw(2) << th->rootMoves[i].selDepth
-                << " multipv "  << i + 1
-                << std::setfill(' ')
-                << " score "    << v;
-            if (Options["UCI_ShowWDL"]) {
-            oss << wdl(v, th->rootPos.clockPly());
-            }
-            if (!tb
-             && i == th->pvCur) {
-            oss << (beta <= v ? " lowerbound" : v <= alfa ? " upperbound" : "");
-            }
-            oss << " nodes "    << nodes
-                << " time "     << elapsed
-                << " nps "      << nodes * 1000 / elapsed
-                << " tbhits "   << tbHits;
-            if (elapsed > 1000) {
-            oss << " hashfull " << TT.hashFull();
-            }
-            oss << " pv "       << th->rootMoves[i];
-            if (i + 1 < Threadpool.pvCount) {
-            oss << '\n';
-            }
+                v = rootMoves[i].tbValue;
+            }
+
+            SearchInfo info;
+            info.depth    = d;
+            info.selDepth = rootMoves[i].selDepth;
+            info.multiPV  = i + 1;
+            info.value    = v;
+            info.bound    =
+                !tb
+             && !merged
+             && i == th->pvCur ?
+                    beta <= v ? BOUND_LOWER :
+                    v <= alfa ? BOUND_UPPER : BOUND_EXACT : BOUND_EXACT;
+            info.wdl[0]   = winRateModel(+v, th->rootPos.clockPly());
+            info.wdl[2]   = winRateModel(-v, th->rootPos.clockPly());
+            info.wdl[1]   = 1000 - info.wdl[0] - info.wdl[2];
+            info.nodes    = nodes;
+            info.time     = elapsed;
+            info.tbHits   = tbHits;
+            info.hashFull = hashFull;
+            info.pv.assign(rootMoves[i].begin(), rootMoves[i].end());
+            ActiveEngine->onInfo(info);
         }
-        return oss.str();
     }
 
     /// quienSearch() is quiescence search function, which is called by the main depth limited search function when the remaining depth <= 0.
@@ -295,6 +300,7 @@ namespace {
         }
 
         ss->inCheck = pos.checkers() != 0;
+        STATS(++pos.thread()->stats.quienNodes);
 
         assert(1 <= ss->ply && ss->ply < MAX_PLY);
         assert(ss->ply == (ss-1)->ply + 1);
@@ -313,7 +319,7 @@ namespace {
         Move move;
         // Transposition table lookup.
         Key const posiKey { pos.posiKey() };
-        auto *const tte   { TT.probe(posiKey, ss->ttHit) };
+        auto *const tte   { probeTT(pos.thread(), posiKey, ss->ttHit) };
         auto const ttValue{ ss->ttHit ? valueOfTT(tte->value(), ss->ply, pos.clockPly()) : VALUE_NONE };
         auto       ttMove { ss->ttHit ? tte->move() : MOVE_NONE };
         auto const ttPV   { ss->ttHit && tte->isPV() };
@@ -331,6 +337,7 @@ namespace {
          && ttValue != VALUE_NONE // Only in case of TT access race
          && tte->depth() >= qsDepth
          && (tte->bound() & (ttValue >= beta ? BOUND_LOWER : BOUND_UPPER))) {
+            STATS(++pos.thread()->stats.quienTTCutoffs);
             return ttValue;
         }
 
@@ -373,7 +380,8 @@ namespace {
                               ss->staticEval,
                               DEPTH_NONE,
                               BOUND_LOWER,
-                              false);
+                              false,
+                              pos.thread()->ttGeneration);
                 }
 
                 assert(-VALUE_INFINITE < bestValue && bestValue < +VALUE_INFINITE);
@@ -426,7 +434,7 @@ namespace {
              && futilityBase > -VALUE_KNOWN_WIN
              && !giveCheck
              && mType(move) != PROMOTE
-             && Limits.mate == 0) {
+             && Limits().mate == 0) {
 
                 // Move Count pruning
                 if (moveCount > 2) {
@@ -450,12 +458,12 @@ namespace {
             // Don't search moves with negative SEE values
             if (bestValue > +VALUE_MATE_2_MAX_PLY
              && !pos.see(move)
-             && Limits.mate == 0) {
+             && Limits().mate == 0) {
                 continue;
             }
 
             // Speculative prefetch as early as possible
-            prefetch(TT.cluster(pos.movePosiKey(move)));
+            prefetch(TT().cluster(pos.movePosiKey(move)));
 
             // Check for legality
             if (!pos.legal(move)) {
@@ -522,7 +530,8 @@ namespace {
                   qsDepth,
                   bestValue >= beta ? BOUND_LOWER :
                   PVNode && bestValue > actualAlfa ? BOUND_EXACT : BOUND_UPPER,
-                  ttPV);
+                  ttPV,
+                  pos.thread()->ttGeneration);
 
         assert(-VALUE_INFINITE < bestValue && bestValue < +VALUE_INFINITE);
         return bestValue;
@@ -566,11 +575,18 @@ namespace {
         // Step 1. Initialize node
         ss->moveCount = 0;
         ss->inCheck = pos.checkers() != 0;
+        STATS(++thread->stats.depthNodes);
 
         // Check for the available remaining limit
-        if (thread == Threadpool.mainThread()) {
+        if (thread == Threadpool().mainThread()) {
             static_cast<MainThread*>(thread)->tick();
         }
+        // Meet the other threads at the sync point of the deterministic search
+        if (Threadpool().deterministic
+         && thread->nodes.load(std::memory_order::memory_order_relaxed) >= thread->syncNodes
+         && !Threadpool().stop.load(std::memory_order::memory_order_relaxed)) {
+            Threadpool().synchronize(thread);
+        }
 
         if (PVNode) {
             // Used to send selDepth info to GUI (selDepth from 1, ply from 0)
@@ -579,7 +595,7 @@ namespace {
 
         if (!rootNode) {
             // Step 2. Check for aborted search, immediate draw or maximum ply reached.
-            if (Threadpool.stop.load(std::memory_order::memory_order_relaxed)
+            if (Threadpool().stop.load(std::memory_order::memory_order_relaxed)
              || pos.draw(ss->ply)
              || ss->ply >= MAX_PLY) {
                 return !ss->inCheck
@@ -629,7 +645,7 @@ namespace {
         Key const posiKey { excludedMove == MOVE_NONE ?
                                 pos.posiKey() :
                                 pos.posiKey() ^ makeKey(excludedMove) };
-        auto *const tte   { TT.probe(posiKey, ss->ttHit) };
+        auto *const tte   { probeTT(thread, posiKey, ss->ttHit) };
         auto const ttValue{ ss->ttHit ? valueOfTT(tte->value(), ss->ply, pos.clockPly()) : VALUE_NONE };
         auto       ttMove { rootNode  ? thread->rootMoves[thread->pvCur][0] :
                             ss->ttHit ? tte->move() : MOVE_NONE };
@@ -683,19 +699,20 @@ namespace {
                 }
             }
 
-            if (pos.clockPly() < std::max(2 * int16_t(Options["Draw MoveCount"]) - 10, 10)) {
+            if (pos.clockPly() < std::max(2 * int16_t(Options()["Draw MoveCount"]) - 10, 10)) {
+                STATS(++thread->stats.ttCutoffs);
                 return ttValue;
             }
         }
 
         // Step 5. Tablebases probe.
         if (!rootNode
-         && SyzygyTB::PieceLimit != 0) {
+         && Threadpool().tbPieceLimit != 0) {
             auto const pieceCount{ pos.count() };
 
-            if (( pieceCount  < SyzygyTB::PieceLimit
-              || (pieceCount == SyzygyTB::PieceLimit
-               && depth >= SyzygyTB::DepthLimit))
+            if (( pieceCount  < Threadpool().tbPieceLimit
+              || (pieceCount == Threadpool().tbPieceLimit
+               && depth >= Threadpool().tbDepthLimit))
              && pos.clockPly() == 0
              && pos.castleRights() == CR_NONE) {
 
@@ -703,14 +720,14 @@ namespace {
                 auto const wdlScore{ SyzygyTB::probeWDL(pos, probeState) };
 
                 // Force check of time on the next occasion
-                if (thread == Threadpool.mainThread()) {
+                if (thread == Threadpool().mainThread()) {
                     static_cast<MainThread*>(thread)->tickCount = 0;
                 }
 
                 if (probeState != SyzygyTB::ProbeState::PS_FAILURE) {
                     thread->tbHits.fetch_add(1, std::memory_order::memory_order_relaxed);
 
-                    int16_t const draw{ SyzygyTB::Move50Rule };
+                    int16_t const draw{ Threadpool().tbMove50Rule };
 
                     value = wdlScore < -draw ? -VALUE_MATE_1_MAX_PLY + (ss->ply + 1) :
                             wdlScore > +draw ? +VALUE_MATE_1_MAX_PLY - (ss->ply + 1) :
@@ -728,7 +745,8 @@ namespace {
                                   VALUE_NONE,
                                   Depth(std::min(depth + 6, MAX_PLY - 1)),
                                   bound,
-                                  ss->ttPV);
+                                  ss->ttPV,
+                                  thread->ttGeneration);
                         return value;
                     }
 
@@ -805,7 +823,8 @@ namespace {
                           eval,
                           DEPTH_NONE,
                           BOUND_NONE,
-                          ss->ttPV);
+                          ss->ttPV,
+                          thread->ttGeneration);
             }
 
             improving = (ss-2)->staticEval != VALUE_NONE ? ss->staticEval > (ss-2)->staticEval :
@@ -827,7 +846,7 @@ namespace {
              && depth < 9
              && eval < +VALUE_KNOWN_WIN // Don't return unproven wins.
              && eval - futilityMargin(depth, improving) >= beta
-             && Limits.mate == 0) {
+             && Limits().mate == 0) {
                 return eval;
             }
 
@@ -843,7 +862,7 @@ namespace {
              // Null move pruning disabled for activeSide until ply exceeds nmpPly
              && (ss->ply >= thread->nmpMinPly
               || activeSide != thread->nmpColor)
-             && Limits.mate == 0) {
+             && Limits().mate == 0) {
                 // Null move dynamic reduction based on depth and static evaluation.
                 Depth const R( (1062 + 68 * depth) / 256 + std::min(int32_t(eval - beta) / 190, 3) );
                 Depth const nullDepth( depth - R );
@@ -851,6 +870,7 @@ namespace {
                 ss->playedMove = MOVE_NULL;
                 ss->pieceStats = &thread->continuationStats[0][0][NO_PIECE][0];
 
+                STATS(++thread->stats.nullMoveTries);
                 pos.doNullMove(si);
 
                 auto nullValue{ -depthSearch<false>(pos, ss+1, -beta, -beta+1, nullDepth, !cutNode) };
@@ -867,6 +887,7 @@ namespace {
                     if (thread->nmpMinPly != 0 // Recursive verification is not allowed
                      || (depth < 14
                       && std::abs(beta) < VALUE_KNOWN_WIN)) {
+                        STATS(++thread->stats.nullMoveCutoffs);
                         return nullValue;
                     }
 
@@ -880,6 +901,7 @@ namespace {
                     thread->nmpMinPly = 0;
 
                     if (value >= beta) {
+                        STATS(++thread->stats.nullMoveCutoffs);
                         return nullValue;
                     }
                 }
@@ -902,7 +924,7 @@ namespace {
                && ttValue != VALUE_NONE
                && ttValue < probCutBeta
                && tte->depth() >= depth - 3)
-             && Limits.mate == 0) {
+             && Limits().mate == 0) {
 
                 // if ttMove is a capture and value from transposition table is good enough produce probCut
                 // cutoff without digging into actual probCut search
@@ -915,6 +937,8 @@ namespace {
                     return probCutBeta;
                 }
 
+                STATS(++thread->stats.probCutTries);
+
                 assert(probCutBeta < +VALUE_INFINITE);
 
                 bool const ttPV{ ss->ttPV };
@@ -945,7 +969,7 @@ namespace {
                     ++probCutCount;
 
                     // Speculative prefetch as early as possible
-                    prefetch(TT.cluster(pos.movePosiKey(move)));
+                    prefetch(TT().cluster(pos.movePosiKey(move)));
 
                     ss->playedMove = move;
                     ss->pieceStats = &thread->continuationStats[ss->inCheck][captureOrPromotion][pos.movedPiece(move)][dstSq(move)];
@@ -967,15 +991,17 @@ namespace {
                         if (!(ss->ttHit
                            && ttValue != VALUE_NONE
                            && tte->depth() >= depth - 3)) {
-                            tte->save(posiKey,
+                            saveEntry(thread, posiKey, tte)->save(posiKey,
                                       move,
                                       valueToTT(value, ss->ply),
                                       ss->staticEval,
                                       depth - 3,
                                       BOUND_LOWER,
-                                      ttPV);
+                                      ttPV,
+                                      thread->ttGeneration);
                         }
 
+                        STATS(++thread->stats.probCutCutoffs);
                         return value;
                     }
                 }
@@ -1050,18 +1076,17 @@ namespace {
             ss->moveCount = ++moveCount;
 
             if (rootNode
-             && thread == Threadpool.mainThread()) {
-                TimePoint const elapsed{ TimeMgr.elapsed() };
-                if (elapsed > 3000) {
-                    sync_cout << std::setfill('0')
-                              << "info"
-                              << " depth "          << std::setw(2) << depth
-                              << " seldepth "       << std::setw(2) << thread->rootMoves.find(thread->pvCur, thread->pvEnd, move)->selDepth
-                              << " currmove "       << move
-                              << " currmovenumber " << std::setw(2) << thread->pvCur + moveCount
-                              //<< " maxmoves "       << thread->rootMoves.size()
-                              << " time "           << elapsed
-                              << std::setfill(' ')  << sync_endl;
+             && thread == Threadpool().mainThread()) {
+                TimePoint const elapsed{ TimeMgr().elapsed() };
+                if (elapsed > 3000
+                 && ActiveEngine->onCurrMove) {
+                    CurrMoveInfo info;
+                    info.depth      = depth;
+                    info.selDepth   = thread->rootMoves.find(thread->pvCur, thread->pvEnd, move)->selDepth;
+                    info.move       = move;
+                    info.moveNumber = thread->pvCur + moveCount;
+                    info.time       = elapsed;
+                    ActiveEngine->onCurrMove(info);
                 }
             }
 
@@ -1088,7 +1113,7 @@ namespace {
             if (!rootNode
              && bestValue > -VALUE_MATE_2_MAX_PLY
              && pos.nonPawnMaterial(activeSide) != VALUE_ZERO
-             && Limits.mate == 0) {
+             && Limits().mate == 0) {
                 // Skip quiet moves if move count exceeds our futilityMoveCount() threshold
                 moveCountPruning = moveCount >= futilityMoveCount(depth, improving);
                 movePicker.pickQuiets = !moveCountPruning;
@@ -1192,7 +1217,7 @@ namespace {
             newDepth += extension;
 
             // Speculative prefetch as early as possible
-            prefetch(TT.cluster(pos.movePosiKey(move)));
+            prefetch(TT().cluster(pos.movePosiKey(move)));
 
             // Update the current move
             ss->playedMove = move;
@@ -1301,6 +1326,8 @@ namespace {
 
                 // If the son is reduced and fails high it will be re-searched at full depth
                 doFullSearch = alfa < value && d < newDepth;
+                STATS(++thread->stats.lmrSearches);
+                STATS(thread->stats.lmrResearches += doFullSearch);
             } else {
                 doFullSearch = !PVNode || moveCount > 1;
             }
@@ -1338,7 +1365,7 @@ namespace {
             // Finished searching the move. If a stop or a cutoff occurred,
             // the return value of the search cannot be trusted,
             // and return immediately without updating best move, PV and TT.
-            if (Threadpool.stop.load(std::memory_order::memory_order_relaxed)) {
+            if (Threadpool().stop.load(std::memory_order::memory_order_relaxed)) {
                 return VALUE_ZERO;
             }
 
@@ -1363,7 +1390,7 @@ namespace {
                     // This information is used for time management:
                     // When the best move changes frequently, allocate some more time.
                     if (moveCount > 1
-                     && Limits.useTimeMgmt()) {
+                     && Limits().useTimeMgmt()) {
                         ++thread->pvChanges;
                     }
                 } else {
@@ -1392,6 +1419,7 @@ namespace {
                     } else {
                         assert(value >= beta); // Fail high
                         ss->stats = 0;
+                        STATS(thread->stats.failHigh(depth, moveCount == 1));
                         break;
                     }
                 }
@@ -1412,7 +1440,7 @@ namespace {
         // completed. But in this case bestValue is valid because we have fully
         // searched our subtree, and we can anyhow save the result in TT.
         /*
-        if (Threadpool.stop) {
+        if (Threadpool().stop) {
             return VALUE_DRAW;
         }
         */
@@ -1487,14 +1515,15 @@ namespace {
 
         if (excludedMove == MOVE_NONE
          && (!rootNode || thread->pvCur == 0)) {
-            tte->save(posiKey,
+            saveEntry(thread, posiKey, tte)->save(posiKey,
                       bestMove,
                       valueToTT(bestValue, ss->ply),
                       ss->staticEval,
                       depth,
                       bestValue >= beta ? BOUND_LOWER :
                       PVNode && bestMove != MOVE_NONE ? BOUND_EXACT : BOUND_UPPER,
-                      ss->ttPV);
+                      ss->ttPV,
+                      thread->ttGeneration);
         }
 
         assert(-VALUE_INFINITE < bestValue && bestValue < +VALUE_INFINITE);
@@ -1509,10 +1538,11 @@ namespace Searcher {
 
     void initialize() noexcept {
 
-        double const r{ 21.3 + 2 * std::log(Threadpool.size()) };
-        Reduction[0] = 0;
+        auto &reductions{ Threadpool().reductions };
+        double const r{ 21.3 + 2 * std::log(Threadpool().size()) };
+        reductions[0] = 0;
         for (int16_t i = 1; i < MAX_MOVES; ++i) {
-            Reduction[i] = int32_t(r * std::log(i + 0.25 * std::log(i)));
+            reductions[i] = int32_t(r * std::log(i + 0.25 * std::log(i)));
         }
     }
 }
@@ -1524,27 +1554,28 @@ namespace Searcher {
 /// - Maximum search depth is reached.
 void Thread::search() {
     ttHitAvg = TTHitAverageWindow * TTHitAverageResolution / 2;
+    ttGeneration = TT().generation();
 
-    int32_t const contemptTime { Options["Contempt Time"] };
-    int32_t const contemptValue{ Options["Contempt Value"] };
+    int32_t const contemptTime { Options()["Contempt Time"] };
+    int32_t const contemptValue{ Options()["Contempt Value"] };
 
     int16_t timedContempt{ 0 };
     if (contemptTime != 0
-     && Limits.useTimeMgmt()) {
+     && Limits().useTimeMgmt()) {
         int64_t const diffTime{
-            (int64_t(Limits.clock[ rootPos.activeSide()].time)
-           - int64_t(Limits.clock[~rootPos.activeSide()].time)) / 1000 };
+            (int64_t(Limits().clock[ rootPos.activeSide()].time)
+           - int64_t(Limits().clock[~rootPos.activeSide()].time)) / 1000 };
         timedContempt = int16_t(diffTime / contemptTime);
     }
     // Basic Contempt
-    int32_t bc{ toValue(int16_t(Options["Fixed Contempt"]) + timedContempt) };
+    int32_t bc{ toValue(int16_t(Options()["Fixed Contempt"]) + timedContempt) };
     // In analysis mode, adjust contempt in accordance with user preference
-    if (Limits.infinite
-     || Options["UCI_AnalyseMode"]) {
-        bc = Options["Analysis Contempt"] == "Off"                                    ? 0 :
-             Options["Analysis Contempt"] == "White" && rootPos.activeSide() == BLACK ? -bc :
-             Options["Analysis Contempt"] == "Black" && rootPos.activeSide() == WHITE ? -bc :
-             /*Options["Analysis Contempt"] == "Both"                         ? +bc :*/ +bc;
+    if (Limits().infinite
+     || Options()["UCI_AnalyseMode"]) {
+        bc = Options()["Analysis Contempt"] == "Off"                                    ? 0 :
+             Options()["Analysis Contempt"] == "White" && rootPos.activeSide() == BLACK ? -bc :
+             Options()["Analysis Contempt"] == "Black" && rootPos.activeSide() == WHITE ? -bc :
+             /*Options()["Analysis Contempt"] == "Both"                         ? +bc :*/ +bc;
     }
     contempt = rootPos.activeSide() == WHITE ?
                 +makeScore(bc, bc / 2) :
@@ -1553,7 +1584,7 @@ void Thread::search() {
     std::copy(&lowPlyStats[2][0], &lowPlyStats.back().back() + 1, &lowPlyStats[0][0]);
     std::fill(&lowPlyStats[MAX_LOWPLY - 2][0], &lowPlyStats.back().back() + 1, 0);
 
-    auto *mainThread{ this == Threadpool.mainThread() ?
+    auto *mainThread{ this == Threadpool().mainThread() ?
                         static_cast<MainThread*>(this) : nullptr };
 
     double  timeReduction{ 1.0 };
@@ -1578,16 +1609,25 @@ void Thread::search() {
     Move pv[MAX_PLY+1];
     ss->pv = pv;
 
+    // Split MultiPV search gives fewer root moves to each group
+    pvCount = std::min(Threadpool().pvCount, uint16_t(rootMoves.size()));
+    if (Threadpool().pvGroups > 1) {
+        std::lock_guard<std::mutex> lockGuard(pvMutex);
+        pvLines.assign(rootMoves.begin(), rootMoves.begin() + pvCount);
+        pvDepth = DEPTH_ZERO;
+    }
+
     // Iterative deepening loop until requested to stop or the target depth is reached.
+    // The first thread of each group of the split MultiPV search also stops at the target depth.
     while (++rootDepth < MAX_PLY
-        && !Threadpool.stop
-        && (!mainThread
-         || Limits.depth == DEPTH_ZERO
-         || rootDepth <= Limits.depth)) {
+        && !Threadpool().stop
+        && (index >= Threadpool().pvGroups
+         || Limits().depth == DEPTH_ZERO
+         || rootDepth <= Limits().depth)) {
 
         if (mainThread) {
             // Age out PV variability metric
-            Threadpool.pvChangesSum /= 2;
+            Threadpool().pvChangesSum /= 2;
         }
 
         // Save the last iteration's values before first PV line is searched and
@@ -1597,12 +1637,12 @@ void Thread::search() {
         uint16_t pvBeg = 0;
         pvEnd = 0;
 
-        if (Threadpool.stand) {
+        if (Threadpool().stand) {
             ++standCount;
         }
 
         // MultiPV loop. Perform a full root search for each PV line.
-        for (pvCur = 0; pvCur < Threadpool.pvCount && !Threadpool.stop; ++pvCur) {
+        for (pvCur = 0; pvCur < pvCount && !Threadpool().stop; ++pvCur) {
 
             if (pvCur == pvEnd) {
                 pvBeg = pvEnd;
@@ -1651,16 +1691,16 @@ void Thread::search() {
 
                 // If search has been stopped, break immediately.
                 // Sorting is safe because RootMoves is still valid, although it refers to the previous iteration.
-                if (Threadpool.stop) {
+                if (Threadpool().stop) {
                     break;
                 }
 
                 // Give some update before to re-search.
                 if (mainThread
-                 && Threadpool.pvCount == 1
+                 && Threadpool().pvCount == 1
                  && (alfa >= bestValue || bestValue >= beta)
-                 && TimeMgr.elapsed() > 3000) {
-                    sync_cout << multipvInfo(mainThread, rootDepth, alfa, beta) << sync_endl;
+                 && TimeMgr().elapsed() > 3000) {
+                    multipvInfo(mainThread, rootDepth, alfa, beta);
                 }
 
                 // If fail low set new bounds
@@ -1670,7 +1710,7 @@ void Thread::search() {
 
                     failHighCount = 0;
                     if (mainThread) {
-                        Threadpool.stopPonderhit = false;
+                        Threadpool().stopPonderhit = false;
                     }
                 } else
                 // If fail high set new bounds
@@ -1693,109 +1733,144 @@ void Thread::search() {
             rootMoves.stableSort(pvBeg, pvCur + 1);
 
             if (mainThread
-             && (Threadpool.stop
-              || Threadpool.pvCount == pvCur + 1
-              || TimeMgr.elapsed() > 3000)) {
-                sync_cout << multipvInfo(mainThread, rootDepth, alfa, beta) << sync_endl;
+             && Threadpool().pvGroups == 1
+             && (Threadpool().stop
+              || pvCount == pvCur + 1
+              || TimeMgr().elapsed() > 3000)) {
+                multipvInfo(mainThread, rootDepth, alfa, beta);
             }
         }
 
-        if (!Threadpool.stop) {
+        if (!Threadpool().stop) {
             finishedDepth = rootDepth;
+
+            // Publish the lines to merge with the other groups
+            if (Threadpool().pvGroups > 1) {
+                {
+                    std::lock_guard<std::mutex> lockGuard(pvMutex);
+                    pvLines.assign(rootMoves.begin(), rootMoves.begin() + pvCount);
+                    pvDepth = rootDepth;
+                }
+                if (mainThread) {
+                    multipvInfo(mainThread, rootDepth, alfa, beta);
+                }
+            }
         }
 
         // Has any of the threads found a "mate in <x>"?
-        if ( Limits.mate != 0
-         && !Limits.useTimeMgmt()
+        if ( Limits().mate != 0
+         && !Limits().useTimeMgmt()
          && bestValue >= +VALUE_MATE_1_MAX_PLY
-         && bestValue >= +VALUE_MATE - 2 * Limits.mate) {
-            Threadpool.stop = true;
+         && bestValue >= +VALUE_MATE - 2 * Limits().mate) {
+            if (Threadpool().deterministic) {
+                Threadpool().requestStop();
+            } else {
+                Threadpool().raiseStop(false);
+            }
         }
 
         if (mainThread) {
 
-            if (Threadpool.bestMove != rootMoves[0][0]) {
-                Threadpool.bestMove  = rootMoves[0][0];
-                Threadpool.bestDepth = rootDepth;
+            if (Threadpool().bestMove != rootMoves[0][0]) {
+                Threadpool().bestMove  = rootMoves[0][0];
+                Threadpool().bestDepth = rootDepth;
             }
 
             // Reduce time if the bestMove is stable over 10 iterations
             // Time Reduction
-            timeReduction = 0.95 + 0.97 * ((finishedDepth - Threadpool.bestDepth) > 9);
+            timeReduction = 0.95 + 0.97 * ((finishedDepth - Threadpool().bestDepth) > 9);
 
-            if ( Limits.useTimeMgmt()
-             && !Threadpool.stop
-             && !Threadpool.stopPonderhit) {
+            if ( Limits().useTimeMgmt()
+             && !Threadpool().stop
+             && !Threadpool().stopPonderhit) {
 
                 // Reduction Ratio - Use part of the gained time from a previous stable move for the current move
-                auto const reductionRatio{ (1.47 + Threadpool.timeReduction) / (2.32 * timeReduction) };
+                auto const reductionRatio{ (1.47 + Threadpool().timeReduction) / (2.32 * timeReduction) };
                 // Eval Falling factor
                 auto const fallingEval{
                     std::clamp((318
-                              + 6 * (Threadpool.bestValue - bestValue)
-                              + 6 * (Threadpool.iterValues[Threadpool.iterIdx] - bestValue)) / 825.0, 0.50, 1.50) };
+                              + 6 * (Threadpool().bestValue - bestValue)
+                              + 6 * (Threadpool().iterValues[Threadpool().iterIdx] - bestValue)) / 825.0, 0.50, 1.50) };
 
-                Threadpool.pvChangesSum += Threadpool.accumulate(&Thread::pvChanges);
+                Threadpool().pvChangesSum += Threadpool().accumulate(&Thread::pvChanges);
                 // Set pvChanges to 0
-                Threadpool.set(&Thread::pvChanges, { 0 });
-                auto const pvInstability{ 1.00 + 2 * Threadpool.pvChangesSum / Threadpool.size() };
+                Threadpool().set(&Thread::pvChanges, { 0 });
+                auto const pvInstability{ 1.00 + 2 * Threadpool().pvChangesSum / Threadpool().size() };
 
-                auto totalTime{ TimeMgr.optimum() * reductionRatio * fallingEval * pvInstability };
+                auto totalTime{ TimeMgr().optimum() * reductionRatio * fallingEval * pvInstability };
                 // Cap used time in case of a single legal move for a better viewer experience in tournaments
                 // yielding correct scores and sufficiently fast moves.
                 if (rootMoves.size() == 1) {
                     totalTime = std::min(totalTime, 500.0);
                 }
 
-                auto const elapsed{ double(TimeMgr.elapsed()) };
+                auto const elapsed{ double(TimeMgr().elapsed()) };
 
                 if (elapsed > totalTime * 0.58) {
 
-                    Threadpool.stand = !Threadpool.ponder;
+                    Threadpool().stand = !Threadpool().ponder;
 
                     // Stop the search if we have exceeded the totalTime (at least 1ms).
                     if (elapsed > totalTime) {
 
                         // If allowed to ponder do not stop the search now but
                         // keep pondering until GUI sends "stop"/"ponderhit".
-                        if (!Threadpool.ponder) {
-                            Threadpool.stop = true;
+                        if (!Threadpool().ponder) {
+                            Threadpool().raiseStop();
                         } else {
-                            Threadpool.stopPonderhit = true;
+                            Threadpool().stopPonderhit = true;
                         }
                     }
                 }
 
-                Threadpool.iterValues[Threadpool.iterIdx] = bestValue;
-                Threadpool.iterIdx = (Threadpool.iterIdx + 1) % Threadpool.iterValues.size();
+                Threadpool().iterValues[Threadpool().iterIdx] = bestValue;
+                Threadpool().iterIdx = (Threadpool().iterIdx + 1) % Threadpool().iterValues.size();
             }
 
             // If skill level is enabled and can pick move, pick a sub-optimal best move.
-            if (SkillMgr.enabled()
-             && SkillMgr.canPick(rootDepth)) {
-                SkillMgr.pickBestMove();
+            if (SkillMgr().enabled()
+             && SkillMgr().canPick(rootDepth)) {
+                SkillMgr().pickBestMove();
             }
         }
     }
 
     if (mainThread) {
-        Threadpool.timeReduction = timeReduction;
+        Threadpool().timeReduction = timeReduction;
+    }
+
+    if (Threadpool().deterministic) {
+        Threadpool().leaveSync(index < Threadpool().pvGroups);
     }
 }
 
 /// MainThread::search() is main thread search function.
 /// It searches from root position and outputs the "bestmove"/"ponder".
 void MainThread::search() {
-    assert(Threadpool.mainThread() == this);
+    assert(Threadpool().mainThread() == this);
 
-    if (Limits.useTimeMgmt()) {
+    if (Limits().useTimeMgmt()) {
         // Initialize the time manager before searching.
-        TimeMgr.setup(rootPos.activeSide(), rootPos.plyCount());
+        TimeMgr().setup(rootPos.activeSide(), rootPos.plyCount());
     }
 
-    TEntry::updateGeneration();
+    // Arm the stop timer at the hard deadline, unless the time is counted in nodes
+    TimePoint hardTime{ 0 };
+    if (Limits().useTimeMgmt()) {
+        if (TimeMgr().timeNodes == 0) {
+            hardTime = std::max(TimeMgr().maximum() - 10, TimePoint(1));
+        }
+    } else
+    if (Limits().moveTime != 0) {
+        hardTime = Limits().moveTime;
+    }
+    auto const deadline{ std::chrono::steady_clock::time_point(std::chrono::milliseconds(TimeMgr().startTime + hardTime)) };
+    bool const pondering{ Threadpool().ponder };
+    if (hardTime != 0) {
+        Threadpool().stopTimer.arm(deadline);
+    }
 
-    Evaluator::NNUE::verify();
+    TT().updateGeneration();
 
     bool think{ true };
 
@@ -1804,18 +1879,19 @@ void MainThread::search() {
 
         rootMoves += MOVE_NONE;
 
-        sync_cout << "info"
-                  << " depth " << 0
-                  << " score " << toString(rootPos.checkers() != 0 ? -VALUE_MATE : VALUE_DRAW)
-                  << " time "  << 0 << sync_endl;
+        if (ActiveEngine->onInfo) {
+            SearchInfo info{};
+            info.value = rootPos.checkers() != 0 ? -VALUE_MATE : VALUE_DRAW;
+            ActiveEngine->onInfo(info);
+        }
     } else {
 
-        if ( Options["Use Book"]
-         &&  Book.enabled
-         && !Limits.infinite
-         &&  Limits.mate == 0) {
+        if ( Options()["Use Book"]
+         &&  Book().enabled
+         && !Limits().infinite
+         &&  Limits().mate == 0) {
 
-            auto bbm{ Book.probe(rootPos, Options["Book Move Num"], Options["Book Pick Best"]) };
+            auto bbm{ Book().probe(rootPos, Options()["Book Move Num"], Options()["Book Pick Best"]) };
             if (bbm != MOVE_NONE
              && rootMoves.contains(bbm)) {
                 think = false;
@@ -1825,7 +1901,7 @@ void MainThread::search() {
                 StateInfo si;
                 ASSERT_ALIGNED(&si, CacheLineSize);
                 rootPos.doMove(bbm, si);
-                auto bpm{ Book.probe(rootPos, Options["Book Move Num"], Options["Book Pick Best"]) };
+                auto bpm{ Book().probe(rootPos, Options()["Book Move Num"], Options()["Book Pick Best"]) };
                 if (bpm != MOVE_NONE) {
                     rootMoves[0] += bpm;
                 }
@@ -1835,36 +1911,45 @@ void MainThread::search() {
 
         if (think) {
 
-            Threadpool.pvChangesSum = 0.0;
-            Threadpool.bestMove  = MOVE_NONE;
-            Threadpool.bestDepth = DEPTH_ZERO;
-            if (Limits.useTimeMgmt()) {
-                Threadpool.iterValues.fill(Threadpool.bestValue != +VALUE_INFINITE ? Threadpool.bestValue : VALUE_ZERO);
-                Threadpool.iterIdx = 0;
+            Threadpool().pvChangesSum = 0.0;
+            Threadpool().bestMove  = MOVE_NONE;
+            Threadpool().bestDepth = DEPTH_ZERO;
+            if (Limits().useTimeMgmt()) {
+                Threadpool().iterValues.fill(Threadpool().bestValue != +VALUE_INFINITE ? Threadpool().bestValue : VALUE_ZERO);
+                Threadpool().iterIdx = 0;
             }
 
             PRNG prng(now());
             double const dbllevel{
-                Options["UCI_LimitStrength"] ?
-                    std::clamp(std::pow((double(Options["UCI_Elo"]) - 1346.6) / 143.4, 1 / 0.806), 0.0, double(MaxLevel)) :
-                    double(Options["Skill Level"]) };
+                Options()["UCI_LimitStrength"] ?
+                    std::clamp(std::pow((double(Options()["UCI_Elo"]) - 1346.6) / 143.4, 1 / 0.806), 0.0, double(MaxLevel)) :
+                    double(Options()["Skill Level"]) };
             uint16_t const intLevel = uint16_t(dbllevel) + ((dbllevel - uint16_t(dbllevel)) * 1024 > prng.rand<uint32_t>() % 1024 ? 1 : 0);
-            SkillMgr.setLevel(intLevel);
+            SkillMgr().setLevel(intLevel);
 
             // Have to play with skill handicap?
             // In this case enable MultiPV search by skill pv size
             // that will use behind the scenes to get a set of possible moves.
-            Threadpool.pvCount = std::clamp(uint16_t(Options["MultiPV"]),
-                                            uint16_t(1 + 3 * SkillMgr.enabled()),
+            Threadpool().pvCount = std::clamp(uint16_t(Options()["MultiPV"]),
+                                            uint16_t(1 + 3 * SkillMgr().enabled()),
                                             uint16_t(rootMoves.size()));
-            assert(Threadpool.pvCount != 0);
+            assert(Threadpool().pvCount != 0);
+
+            // Split MultiPV search deals out the root moves to groups of threads, each group searches
+            // the best lines among its moves, and the lines of all the groups are merged
+            Threadpool().pvGroups = Options()["Split MultiPV"]
+                                 && !SkillMgr().enabled() ?
+                                        std::min(Threadpool().pvCount, uint16_t(Threadpool().size())) : 1;
+            if (Threadpool().pvGroups > 1) {
+                Threadpool().splitRootMoves();
+            }
 
-            Threadpool.wakeUpAll(); // start non-main threads searching !
+            Threadpool().wakeUpAll(); // start non-main threads searching !
             Thread::search();           // start main thread searching !
 
             // Swap best PV line with the sub-optimal one if skill level is enabled
-            if (SkillMgr.enabled()) {
-                rootMoves.bringToFront(SkillMgr.bestMove != MOVE_NONE ? SkillMgr.bestMove : SkillMgr.pickBestMove());
+            if (SkillMgr().enabled()) {
+                rootMoves.bringToFront(SkillMgr().bestMove != MOVE_NONE ? SkillMgr().bestMove : SkillMgr().pickBestMove());
             }
         }
     }
@@ -1874,29 +1959,60 @@ void MainThread::search() {
     // before receiving a "stop"/"ponderhit" command. Therefore simply wait here until
     // receives one of those commands (which also raises Threads.stop).
     // Busy wait for a "stop"/"ponderhit" command.
-    while (!Threadpool.stop
-        && (Threadpool.ponder
-         || Limits.infinite)) {
+    while (!Threadpool().stop
+        && (Threadpool().ponder
+         || Limits().infinite)) {
     } // Busy wait for a stop or a ponder reset
 
     Thread *bestThread{ this };
     if (think) {
         // Stop the threads if not already stopped (Also raise the stop if "ponderhit" just reset Threads.ponder)
-        Threadpool.stop = true;
+        // Deterministic search stops them at the next sync point, as requested by the main thread leaving.
+        if (!Threadpool().deterministic) {
+            // Let the other groups of the split MultiPV search reach the target depth
+            if (Limits().depth != DEPTH_ZERO) {
+                for (uint16_t g = 1; g < Threadpool().pvGroups; ++g) {
+                    Threadpool()[g]->waitIdle();
+                }
+            }
+            Threadpool().raiseStop(false);
+        }
         // Wait until non-main threads have finished
-        Threadpool.waitIdleAll();
+        Threadpool().waitIdleAll();
+        if (Threadpool().deterministic) {
+            Threadpool().flushBuffers();
+        }
+
+#if defined(USE_STATS)
+        SearchStats sumStats{};
+        SyzygyTB::ProbeStats sumTBStats{};
+        for (auto const *th : Threadpool()) {
+            sumStats += th->stats;
+            sumTBStats += th->tbStats;
+        }
+        Threadpool().searchStats += sumStats;
+        Threadpool().tbStats += sumTBStats;
+        std::cerr << "\nSearch statistics\n" << sumStats.toString() << sumTBStats.toString();
+#endif
+
+        // Merge the lines of the groups of the split MultiPV search
+        if (Threadpool().pvGroups > 1) {
+            std::vector<Depth> depths;
+            rootMoves = Threadpool().mergedLines(depths);
+            multipvInfo(this, finishedDepth, -VALUE_INFINITE, +VALUE_INFINITE);
+        }
 
         // Check if there is better thread than main thread
-        if (Threadpool.pvCount == 1
-         && Threadpool.size() >= 2
-         //&& Limits.depth == DEPTH_ZERO // Depth limit search don't use deeper thread
-         && !SkillMgr.enabled()
-         && !Options["UCI_LimitStrength"]) {
+        if (Threadpool().pvCount == 1
+         && Threadpool().size() >= 2
+         //&& Limits().depth == DEPTH_ZERO // Depth limit search don't use deeper thread
+         && !SkillMgr().enabled()
+         && !Options()["UCI_LimitStrength"]) {
 
-            bestThread = Threadpool.bestThread();
+            bestThread = Threadpool().bestThread();
             // If new best thread then send PV info again
             if (bestThread != this) {
-                sync_cout << multipvInfo(bestThread, bestThread->finishedDepth, -VALUE_INFINITE, +VALUE_INFINITE) << sync_endl;
+                multipvInfo(bestThread, bestThread->finishedDepth, -VALUE_INFINITE, +VALUE_INFINITE);
             }
         }
     }
@@ -1906,44 +2022,55 @@ void MainThread::search() {
 
     auto &rm{ bestThread->rootMoves[0] };
 
-    if (Limits.useTimeMgmt()) {
-        if (TimeMgr.timeNodes != 0) {
+    // Record the latencies of the stop and of the hard deadline to the bestmove
+    Threadpool().stopTimer.disarm();
+    if (think) {
+        auto const endTime{ std::chrono::steady_clock::now() };
+        auto const stopTime{ std::chrono::steady_clock::time_point(std::chrono::nanoseconds(Threadpool().stopTime.load())) };
+        if (stopTime >= Threadpool().goTime) {
+            Threadpool().stopLatency.add(std::chrono::duration_cast<std::chrono::microseconds>(endTime - stopTime).count());
+        }
+        if (hardTime != 0
+         && !pondering
+         && endTime >= deadline) {
+            Threadpool().deadlineLatency.add(std::chrono::duration_cast<std::chrono::microseconds>(endTime - deadline).count());
+        }
+    }
+
+    if (Limits().useTimeMgmt()) {
+        if (TimeMgr().timeNodes != 0) {
             // In 'Nodes as Time' mode, subtract the searched nodes from the total nodes.
-            TimeMgr.remainingNodes[rootPos.activeSide()] +=
-                Limits.clock[rootPos.activeSide()].inc - Threadpool.accumulate(&Thread::nodes);
+            TimeMgr().remainingNodes[rootPos.activeSide()] +=
+                Limits().clock[rootPos.activeSide()].inc - Threadpool().accumulate(&Thread::nodes);
         }
-        Threadpool.bestValue = rm.newValue;
+        Threadpool().bestValue = rm.newValue;
     }
 
     auto bm{ rm[0] };
     auto pm{ MOVE_NONE };
     if (bm != MOVE_NONE) {
         auto const itr{ rm.begin() + 1 };
-        pm = itr != rm.end() ? *itr : TT.extractNextMove(rootPos, bm);
+        pm = itr != rm.end() ? *itr : TT().extractNextMove(rootPos, bm);
         assert(bm != pm);
     }
 
     // Best move could be MOVE_NONE when searching on a stalemate position.
-    sync_cout << "bestmove " << bm;
-    if (pm != MOVE_NONE) {
-        std::cout << " ponder " << pm;
+    if (ActiveEngine->onBestMove) {
+        ActiveEngine->onBestMove(bm, pm);
     }
-    std::cout << sync_endl;
 }
 
 /// MainThread::tick() is used as timer function.
 /// Used to detect when out of available limit and thus stop the search, also print debug info.
 void MainThread::tick() {
-    static TimePoint reportTime{ now() };
-
     if (--tickCount > 0) {
         return;
     }
     // When using nodes, ensure checking rate is in range [1, 1024]
-    tickCount = int16_t(Limits.nodes != 0 ? std::clamp(int32_t(Limits.nodes / 1024), 1, 1024) : 1024);
+    tickCount = int16_t(Limits().nodes != 0 ? std::clamp(int32_t(Limits().nodes / 1024), 1, 1024) : 1024);
 
-    TimePoint elapsed{ TimeMgr.elapsed() };
-    TimePoint time{ TimeMgr.startTime + elapsed };
+    TimePoint elapsed{ TimeMgr().elapsed() };
+    TimePoint time{ TimeMgr().startTime + elapsed };
 
     if (reportTime + 1000 <= time) {
         reportTime = time;
@@ -1952,18 +2079,19 @@ void MainThread::tick() {
     }
 
     // Do not stop until told so by the GUI.
-    if (Threadpool.ponder) {
+    if (Threadpool().ponder) {
         return;
     }
 
-    if ((Limits.useTimeMgmt()
-      && (Threadpool.stopPonderhit
-       || TimeMgr.maximum() < elapsed + 10))
-     || (Limits.moveTime != 0
-      && Limits.moveTime <= elapsed)
-     || (Limits.nodes != 0
-      && Limits.nodes <= Threadpool.accumulate(&Thread::nodes))) {
-        Threadpool.stop = true;
+    if ((Limits().useTimeMgmt()
+      && (Threadpool().stopPonderhit
+       || TimeMgr().maximum() < elapsed + 10))
+     || (Limits().moveTime != 0
+      && Limits().moveTime <= elapsed)
+     || (Limits().nodes != 0
+      && !Threadpool().deterministic // Checked at the sync points
+      && Limits().nodes <= Threadpool().accumulate(&Thread::nodes))) {
+        Threadpool().raiseStop();
     }
 }
 
@@ -1971,33 +2099,37 @@ namespace SyzygyTB {
 
     void rankRootMoves(Position &pos, RootMoves &rootMoves) noexcept {
 
-        DepthLimit = Options["SyzygyDepthLimit"];
-        PieceLimit = Options["SyzygyPieceLimit"];
-        Move50Rule = Options["SyzygyMove50Rule"];
-        HasRoot    = false;
+        auto &depthLimit{ Threadpool().tbDepthLimit };
+        auto &pieceLimit{ Threadpool().tbPieceLimit };
+        auto &hasRoot{ Threadpool().tbHasRoot };
+
+        depthLimit = Options()["SyzygyDepthLimit"];
+        pieceLimit = Options()["SyzygyPieceLimit"];
+        hasRoot    = false;
+        Threadpool().tbMove50Rule = Options()["SyzygyMove50Rule"];
 
         bool dtzAvailable{ true };
 
         // Tables with fewer pieces than SyzygyProbeLimit are searched with DepthLimit == DEPTH_ZERO
-        if (PieceLimit > MaxPieceLimit) {
-            PieceLimit = MaxPieceLimit;
-            DepthLimit = DEPTH_ZERO;
+        if (pieceLimit > MaxPieceLimit) {
+            pieceLimit = MaxPieceLimit;
+            depthLimit = DEPTH_ZERO;
         }
 
         // Rank moves using DTZ tables
-        if (PieceLimit >= pos.count()
+        if (pieceLimit >= pos.count()
          && pos.castleRights() == CR_NONE) {
             // If the current root position is in the table-bases,
             // then RootMoves contains only moves that preserve the draw or the win.
-            HasRoot = rootProbeDTZ(pos, rootMoves);
-            if (!HasRoot) {
+            hasRoot = rootProbeDTZ(pos, rootMoves);
+            if (!hasRoot) {
                 // DTZ tables are missing; try to rank moves using WDL tables
                 dtzAvailable = false;
-                HasRoot = rootProbeWDL(pos, rootMoves);
+                hasRoot = rootProbeWDL(pos, rootMoves);
             }
         }
 
-        if (HasRoot) {
+        if (hasRoot) {
             // Sort moves according to TB rank
             rootMoves.stableSort([](RootMove const &rm1, RootMove const &rm2) {
                                     return rm1.tbRank > rm2.tbRank;
@@ -2005,7 +2137,7 @@ namespace SyzygyTB {
             // Probe during search only if DTZ is not available and winning
             if (dtzAvailable
              || rootMoves[0].tbValue <= VALUE_DRAW) {
-                PieceLimit = 0;
+                pieceLimit = 0;
             }
         } else {
             // Clean up if rootProbeDTZ() and rootProbeWDL() have failed
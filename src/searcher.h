@@ -57,10 +57,42 @@ struct Limit {
     Moves     searchMoves;  // Restrict search to these root moves only
 };
 
+/// SearchInfo stores the information of one PV line sent by the search
+///  - Depth, Selective Depth and Line number
+///  - Value and Bound (BOUND_EXACT unless the line failed low/high)
+///  - Win/Draw/Loss per mille
+///  - Nodes, Time in milli-seconds, TB Hits and Hash full per mille (-1 if not computed)
+///  - Principal Variation
+/// With no legal moves the depth is zero and the PV is empty.
+struct SearchInfo {
+
+    Depth     depth;
+    Depth     selDepth;
+    uint16_t  multiPV;
+    Value     value;
+    Bound     bound;
+    int16_t   wdl[3];
+    uint64_t  nodes;
+    TimePoint time;
+    uint64_t  tbHits;
+    int16_t   hashFull;
+    Moves     pv;
+};
+
+/// CurrMoveInfo stores the root move being searched by the main thread
+struct CurrMoveInfo {
+
+    Depth     depth;
+    Depth     selDepth;
+    Move      move;
+    uint16_t  moveNumber;
+    TimePoint time;
+};
+
 namespace Searcher {
 
     extern void initialize() noexcept;
 }
 
-// Global Limit
-extern Limit Limits;
+// Limit of the active engine
+extern Limit& Limits() noexcept;
@@ -4,9 +4,7 @@
 #include "thread.h"
 #include "helper/prng.h"
 
-SkillManager SkillMgr;
-
-constexpr SkillManager::SkillManager() noexcept :
+SkillManager::SkillManager() noexcept :
     bestMove{ MOVE_NONE },
     level{ MaxLevel } {
 }
@@ -28,15 +26,15 @@ void SkillManager::setLevel(uint16_t lvl) noexcept {
 Move SkillManager::pickBestMove() noexcept {
     static PRNG prng(now()); // PRNG sequence should be non-deterministic.
 
-    auto const &rootMoves{ Threadpool.mainThread()->rootMoves };
+    auto const &rootMoves{ Threadpool().mainThread()->rootMoves };
     assert(!rootMoves.empty());
 
     // RootMoves are already sorted by value in descending order
     int32_t const weakness{ MAX_PLY / 2 - 2 * level };
-    int32_t const deviance{ std::min(rootMoves[0].newValue - rootMoves[Threadpool.pvCount - 1].newValue, VALUE_MG_PAWN) };
+    int32_t const deviance{ std::min(rootMoves[0].newValue - rootMoves[Threadpool().pvCount - 1].newValue, VALUE_MG_PAWN) };
 
     auto bestValue{ -VALUE_INFINITE };
-    for (uint16_t i = 0; i < Threadpool.pvCount; ++i) {
+    for (uint16_t i = 0; i < Threadpool().pvCount; ++i) {
         // First for each move score add two terms, both dependent on weakness.
         // One is deterministic with weakness, and one is random with weakness.
         auto const value{
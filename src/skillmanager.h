@@ -10,7 +10,7 @@ class SkillManager final {
 
 public:
 
-    constexpr SkillManager() noexcept;
+    SkillManager() noexcept;
     SkillManager(SkillManager const&) = delete;
     SkillManager(SkillManager&&) = delete;
 
@@ -31,5 +31,5 @@ private:
     uint16_t level;
 };
 
-// Global Skill Manager
-extern SkillManager SkillMgr;
+// Skill Manager of the active engine
+extern SkillManager& SkillMgr() noexcept;
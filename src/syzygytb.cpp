@@ -2,21 +2,31 @@
 
 #include <cstdint>
 #include <cstdlib>
+#include <cctype>
 #include <cstring> // For memset(), memcmp()
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <deque>
 #include <fstream>
+#include <iomanip>
+#include <list>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <string_view>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include "bitboard.h"
+#include "engine.h"
 #include "movegenerator.h"
 #include "notation.h"
 #include "position.h"
 #include "thread.h"
 #include "uci.h"
+#include "helper/prng.h"
 #include "helper/string.h"
 #include "helper/string_view.h"
 
@@ -36,6 +46,7 @@
     #include <fcntl.h>
     #include <unistd.h>
     #include <sys/mman.h>
+    #include <sys/resource.h>
     #include <sys/stat.h>
 #endif
 
@@ -321,6 +332,13 @@ namespace {
         uint16_t    mapIdx[4];              // WDLWin, WDLLoss, WDLCursedWin, WDLBlessedLoss (used in DTZ)
     };
 
+    /// State of the mapping of a table, the first thread to probe it maps it
+    enum MapState : uint8_t {
+        MS_NONE,
+        MS_MAPPING,
+        MS_READY
+    };
+
     /// struct TBTable contains indexing information to access the corresponding TBFile.
     /// There are 2 types of TBTable, corresponding to a WDL or a DTZ file.
     /// TBTable is populated at init time but the nested PairsData records are
@@ -331,7 +349,7 @@ namespace {
 
         static constexpr int16_t Sides{ Type == WDL ? 2 : 1 };
 
-        std::atomic<bool> ready;
+        std::atomic<MapState> state;
         void    *baseAddress;
         uint8_t *map;
         uint64_t mapping;
@@ -348,7 +366,7 @@ namespace {
         }
 
         TBTable() noexcept :
-            ready{ false },
+            state{ MS_NONE },
             baseAddress{ nullptr },
             map{ nullptr },
             mapping{ 0 } {
@@ -437,12 +455,18 @@ namespace {
             std::memset(entry, 0, sizeof(entry));
             wdlTable.clear();
             dtzTable.clear();
+            codes.clear();
         }
 
         size_t size() const noexcept {
             return wdlTable.size();
         }
 
+        // Code of the i-th table found, like "KRPvK"
+        std::string const& code(size_t i) const noexcept {
+            return codes[i];
+        }
+
         void add(std::vector<PieceType> const &pieces) {
 
             std::ostringstream oss;
@@ -461,6 +485,7 @@ namespace {
 
             wdlTable.emplace_back(code);
             dtzTable.emplace_back(wdlTable.back());
+            codes.push_back(code);
             // Insert into the hash keys for both colors: KRvK with KR white and black
             insert(wdlTable.back().matlKey1, &wdlTable.back(), &dtzTable.back());
             insert(wdlTable.back().matlKey2, &wdlTable.back(), &dtzTable.back());
@@ -512,9 +537,238 @@ namespace {
 
         std::deque<TBTable<WDL>> wdlTable;
         std::deque<TBTable<DTZ>> dtzTable;
+        std::vector<std::string> codes;
     };
 
     TBTableDB TBTables;
+    // Changes with the tables, to invalidate the results cached by the threads
+    uint32_t TBGeneration{ 0 };
+    // Set on the threads of benchProbe(), which share the search threads:
+    // they probe without the cache and the statistics of the thread
+    thread_local bool BenchProbing{ false };
+
+    /// scanBlock() reads the Huffman symbols of the block in order, passing each one to the visitor
+    /// until it returns false, before the symbol is consumed.
+    template<typename Visit>
+    void scanBlock(PairsData *d, uint32_t block, Visit visit) noexcept {
+        // Start address of the block of canonical Huffman symbols
+        uint32_t *ptr = (uint32_t*)(d->data + ((uint64_t)block * d->blockSize));
+
+        // Read the first 64 bits in our block, this is a (truncated) sequence of
+        // unknown number of symbols of unknown length but we know the first one
+        // is at the beginning of this 64 bits sequence.
+        uint64_t buf64{ number<uint64_t, false>(ptr) }; ptr += 2;
+        int32_t buf64Size{ 64 };
+
+        while (true) {
+            int32_t len{ 0 }; // This is the symbol length - d->minSymLen
+
+            // Now get the symbol length. For any symbol s64 of length l right-padded
+            // to 64 bits we know that d->base64[l-1] >= s64 >= d->base64[l] so we
+            // can find the symbol length iterating through base64[].
+            while (buf64 < d->base64[len]) {
+                ++len;
+            }
+
+            // All the symbols of a given length are consecutive integers (numerical
+            // sequence property), so we can compute the offset of our symbol of
+            // length len, stored at the beginning of buf64.
+            Symbol sym = Symbol((buf64 - d->base64[len]) >> (64 - len - d->minSymLen));
+
+            // Now add the value of the lowest symbol of length len to get our symbol
+            sym += number<Symbol, true>(&d->lowestSym[len]);
+
+            if (!visit(sym)) {
+                break;
+            }
+
+            len += d->minSymLen;  // Get the real length
+            buf64 <<= len;          // Consume the just processed symbol
+            buf64Size -= len;
+
+            if (buf64Size <= 32) {
+                // Refill the buffer
+                buf64Size += 32;
+                buf64 |= (uint64_t)(number<uint32_t, false>(ptr++)) << (64 - buf64Size);
+            }
+        }
+    }
+
+    /// BlockCache keeps the most recently used blocks Huffman-decoded, shared by all the threads:
+    /// the symbols of a block with the count of values up to each, so the symbol of a value is
+    /// found by a binary search instead of reading the block from its start.
+    /// A block is decoded only at its second miss while remembered, so the blocks probed once
+    /// don't evict the hot ones. The blocks are spread on lock-striped LRU lists,
+    /// a probe finding its stripe locked reads the block from the table rather than waiting.
+    /// The blocks missed once are remembered lock-free, by the hash of their key.
+    /// Only the long blocks (DTZ) are cached, a short block (WDL) is read about as fast as looked up.
+    class BlockCache final {
+
+    public:
+
+        static constexpr uint16_t Stripes{ 64 };
+        // Blocks shorter are read from the table
+        static constexpr size_t MinBlockSize{ 128 };
+        // Blocks missed once remembered, direct mapped
+        static constexpr size_t Ghosts{ 0x10000 };
+
+        bool enabled() const noexcept {
+            return capacity.load(std::memory_order::memory_order_relaxed) != 0;
+        }
+
+        size_t mbSize() const noexcept {
+            return capacity.load(std::memory_order::memory_order_relaxed) * Stripes / (1024 * 1024);
+        }
+
+        /// resize() sets the memory of the cache in MB, 0 disables it.
+        void resize(size_t mbSize) {
+            capacity = mbSize * 1024 * 1024 / Stripes;
+            clear();
+        }
+
+        void clear() {
+            for (auto &stripe : stripes) {
+                std::lock_guard<std::mutex> lock(stripe.mutex);
+                stripe.blocks.clear();
+                stripe.index.clear();
+                stripe.size = 0;
+            }
+            for (auto &ghost : ghosts) {
+                ghost.store(0, std::memory_order::memory_order_relaxed);
+            }
+        }
+
+        /// resetCounts() clears the counts of the lookups, which add up until then.
+        void resetCounts() noexcept {
+            for (auto &stripe : stripes) {
+                stripe.hits.store(0, std::memory_order::memory_order_relaxed);
+                stripe.misses.store(0, std::memory_order::memory_order_relaxed);
+            }
+        }
+
+        /// find() gets the symbol holding the value at the offset of the block, and the offset within it.
+        /// Returns false if the block isn't cached, then it is to be read from the table.
+        bool find(PairsData *d, uint32_t block, int32_t &offset, Symbol &sym) {
+            BlockKey const key{ d, block };
+            size_t const hash{ BlockHash{}(key) };
+            auto &stripe{ stripes[hash % Stripes] };
+            {
+                std::unique_lock<std::mutex> lock(stripe.mutex, std::try_to_lock);
+                if (lock.owns_lock()) {
+                    auto itr{ stripe.index.find(key) };
+                    if (itr != stripe.index.end()) {
+                        stripe.hits.fetch_add(1, std::memory_order::memory_order_relaxed);
+                        // Move to the front, most recently used
+                        stripe.blocks.splice(stripe.blocks.begin(), stripe.blocks, itr->second);
+                        locate(itr->second->runs, offset, sym);
+                        return true;
+                    }
+                }
+            }
+            stripe.misses.fetch_add(1, std::memory_order::memory_order_relaxed);
+
+            // Decode at the second miss only, a ghost of another block in the slot is a first miss
+            uint64_t const tag{ uint64_t(hash) | 1 };
+            auto &ghost{ ghosts[(hash / Stripes) % Ghosts] };
+            if (ghost.load(std::memory_order::memory_order_relaxed) != tag) {
+                ghost.store(tag, std::memory_order::memory_order_relaxed);
+                return false;
+            }
+
+            // Missed again, decode the block out of the lock
+            Block b{ key, {} };
+            uint32_t const count{ uint32_t(d->blockLength[block]) + 1 };
+            uint32_t end{ 0 };
+            scanBlock(d, block, [&](Symbol s) {
+                end += d->symLen[s] + 1;
+                b.runs.push_back({ end, s });
+                return end < count;
+            });
+            b.runs.shrink_to_fit();
+            locate(b.runs, offset, sym);
+
+            std::lock_guard<std::mutex> lock(stripe.mutex);
+            if (stripe.index.count(key) == 0) {
+                stripe.size += sizeOf(b);
+                stripe.blocks.push_front(std::move(b));
+                stripe.index.emplace(key, stripe.blocks.begin());
+                // Evict the least recently used, keeping at least the new one
+                while (stripe.size > capacity.load(std::memory_order::memory_order_relaxed)
+                    && stripe.blocks.size() > 1) {
+                    stripe.size -= sizeOf(stripe.blocks.back());
+                    stripe.index.erase(stripe.blocks.back().key);
+                    stripe.blocks.pop_back();
+                }
+            }
+            return true;
+        }
+
+        /// toString() returns the counts of the lookups since the last reset, and the size of the cache.
+        std::string toString() {
+            uint64_t hits{ 0 }, misses{ 0 }, blocks{ 0 }, size{ 0 };
+            for (auto &stripe : stripes) {
+                hits   += stripe.hits.load(std::memory_order::memory_order_relaxed);
+                misses += stripe.misses.load(std::memory_order::memory_order_relaxed);
+                std::lock_guard<std::mutex> lock(stripe.mutex);
+                blocks += stripe.blocks.size();
+                size   += stripe.size;
+            }
+            std::ostringstream oss;
+            oss << "hits " << hits << " of " << hits + misses << " lookups"
+                << " (" << (hits + misses != 0 ? 100 * hits / (hits + misses) : 0) << "%), "
+                << blocks << " blocks, " << size / 1024 << " KB";
+            return oss.str();
+        }
+
+    private:
+
+        // Values up to and including the symbol
+        struct Run {
+            uint32_t end;
+            Symbol   sym;
+        };
+
+        using BlockKey = std::pair<PairsData const*, uint32_t>;
+
+        struct BlockHash {
+            size_t operator()(BlockKey const &key) const noexcept {
+                return size_t((uintptr_t(key.first) >> 4) * 0x9E3779B97F4A7C15ULL ^ key.second);
+            }
+        };
+
+        struct Block {
+            BlockKey key;
+            std::vector<Run> runs;
+        };
+
+        struct Stripe {
+            std::mutex mutex;
+            std::list<Block> blocks; // Most recently used first
+            std::unordered_map<BlockKey, std::list<Block>::iterator, BlockHash> index;
+            size_t   size{ 0 }; // Bytes of the blocks
+            std::atomic<uint64_t> hits{ 0 };
+            std::atomic<uint64_t> misses{ 0 };
+        };
+
+        static size_t sizeOf(Block const &b) noexcept {
+            // With the list node and the index entry
+            return sizeof(Block) + 64 + b.runs.size() * sizeof(Run);
+        }
+
+        static void locate(std::vector<Run> const &runs, int32_t &offset, Symbol &sym) noexcept {
+            auto const itr{ std::upper_bound(runs.begin(), runs.end(), uint32_t(offset),
+                                [](uint32_t off, Run const &run) { return off < run.end; }) };
+            assert(itr != runs.end());
+            offset -= itr != runs.begin() ? int32_t((itr - 1)->end) : 0;
+            sym = itr->sym;
+        }
+
+        std::atomic<size_t> capacity{ 0 }; // Bytes per stripe
+        Stripe stripes[Stripes];
+        std::atomic<uint64_t> ghosts[Ghosts]{};
+    };
+
+    BlockCache TBBlockCache;
 
     /// TB tables are compressed with canonical Huffman code. The compressed data is divided into
     /// blocks of size d->blockSize, and each block stores a variable number of symbols.
@@ -578,50 +832,21 @@ namespace {
             offset -= d->blockLength[block++] + 1;
         }
 
-        // Finally, we find the start address of our block of canonical Huffman symbols
-        uint32_t *ptr = (uint32_t*)(d->data + ((uint64_t)block * d->blockSize));
-
-        // Read the first 64 bits in our block, this is a (truncated) sequence of
-        // unknown number of symbols of unknown length but we know the first one
-        // is at the beginning of this 64 bits sequence.
-        uint64_t buf64{ number<uint64_t, false>(ptr) }; ptr += 2;
-        int32_t buf64Size{ 64 };
+        // Finally, we find our symbol in the block, it expands into d->symLen[sym] + 1 values
         Symbol sym;
-
-        while (true) {
-            int32_t len{ 0 }; // This is the symbol length - d->minSymLen
-
-            // Now get the symbol length. For any symbol s64 of length l right-padded
-            // to 64 bits we know that d->base64[l-1] >= s64 >= d->base64[l] so we
-            // can find the symbol length iterating through base64[].
-            while (buf64 < d->base64[len]) {
-                ++len;
-            }
-
-            // All the symbols of a given length are consecutive integers (numerical
-            // sequence property), so we can compute the offset of our symbol of
-            // length len, stored at the beginning of buf64.
-            sym = Symbol((buf64 - d->base64[len]) >> (64 - len - d->minSymLen));
-
-            // Now add the value of the lowest symbol of length len to get our symbol
-            sym += number<Symbol, true>(&d->lowestSym[len]);
-
-            // If our offset is within the number of values represented by symbol sym
-            if (offset < d->symLen[sym] + 1) {
-                break;
-            }
-
-            // ...otherwise update the offset and continue to iterate
-            offset -= d->symLen[sym] + 1;
-            len += d->minSymLen;  // Get the real length
-            buf64 <<= len;          // Consume the just processed symbol
-            buf64Size -= len;
-
-            if (buf64Size <= 32) {
-                // Refill the buffer
-                buf64Size += 32;
-                buf64 |= (uint64_t)(number<uint32_t, false>(ptr++)) << (64 - buf64Size);
-            }
+        if (d->blockSize < BlockCache::MinBlockSize
+         || !TBBlockCache.enabled()
+         || !TBBlockCache.find(d, block, offset, sym)) {
+            scanBlock(d, block, [&](Symbol s) {
+                // If our offset is within the number of values represented by symbol s
+                if (offset < d->symLen[s] + 1) {
+                    sym = s;
+                    return false;
+                }
+                // ...otherwise update the offset and continue to iterate
+                offset -= d->symLen[s] + 1;
+                return true;
+            });
         }
 
         // Ok, now we have our symbol that expands into d->symLen[sym] + 1 symbols.
@@ -1228,26 +1453,67 @@ namespace {
         }
     }
 
+#if defined(USE_STATS)
+    /// majorFaults() returns the major page faults (read from the disk) of the calling thread so far.
+    uint64_t majorFaults() noexcept {
+    #if defined(_WIN32)
+        return 0;
+    #else
+        rusage usage;
+        #if defined(RUSAGE_THREAD)
+        getrusage(RUSAGE_THREAD, &usage);
+        #else
+        getrusage(RUSAGE_SELF, &usage);
+        #endif
+        return uint64_t(usage.ru_majflt);
+    #endif
+    }
+
+    /// Meter measures the time and the major page faults of the calling thread since its creation.
+    /// The faults are read before the time when starting, and after it when stopping,
+    /// so the getrusage() calls stay out of the measured time.
+    struct Meter final {
+
+        uint64_t time() const noexcept {
+            return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count());
+        }
+        uint64_t faults() const noexcept {
+            return majorFaults() - startFaults;
+        }
+
+        // Initialized in the declaration order
+        uint64_t const startFaults{ majorFaults() };
+        std::chrono::steady_clock::time_point const startTime{ std::chrono::steady_clock::now() };
+    };
+#endif
+
     // If the TB file corresponding to the given position is already memory mapped
     // then return its base address, otherwise try to memory map and init it. Called
     // at every probe, memory map and init only at first access. Function is thread
-    // safe and can be called concurrently.
+    // safe and can be called concurrently: the thread winning the state maps the table,
+    // the others probing the same table wait for it, other tables map in parallel.
     template<TBType Type>
     void* mapped(TBTable<Type> &e, Position const &pos) {
-        static std::mutex mutex;
 
-        // Use 'acquire' to avoid a thread reading 'ready' == true while
+        // Use 'acquire' to avoid a thread reading the state ready while
         // another is still working. (compiler reordering may cause this).
-        if (e.ready.load(std::memory_order::memory_order_acquire)) {
+        if (e.state.load(std::memory_order::memory_order_acquire) == MS_READY) {
             return e.baseAddress; // Could be nullptr if file does not exist
         }
 
-        std::scoped_lock<std::mutex> scopedLock(mutex);
-
-        if (e.ready.load(std::memory_order::memory_order_relaxed)) { // Recheck under lock
+        auto expected{ MS_NONE };
+        if (!e.state.compare_exchange_strong(expected, MS_MAPPING, std::memory_order::memory_order_acquire)) {
+            // Mapping takes a disk access, nothing to spin for
+            while (e.state.load(std::memory_order::memory_order_acquire) != MS_READY) {
+                std::this_thread::yield();
+            }
             return e.baseAddress;
         }
 
+    #if defined(USE_STATS)
+        Meter const meter;
+    #endif
+
         // Pieces strings in decreasing order for each color, like ("KPP","KR")
         std::string w, b;
         for (PieceType pt = KING; pt >= PAWN; --pt) {
@@ -1262,12 +1528,224 @@ namespace {
             set(e, data);
         }
 
-        e.ready.store(true, std::memory_order::memory_order_release);
+    #if defined(USE_STATS)
+        auto const time{ meter.time() };
+        auto const faults{ meter.faults() };
+        if (pos.thread() != nullptr
+         && !BenchProbing) {
+            pos.thread()->tbStats.addMap(time, faults);
+        }
+    #endif
+
+        e.state.store(MS_READY, std::memory_order::memory_order_release);
         return e.baseAddress;
     }
 
+    // Tables up to this size are read ahead whole by the warm-up, the bigger ones only mapped
+    constexpr uint64_t WarmupReadSize{ 32 * 1024 * 1024 };
+    // Mapping waits on the disk, not the processor
+    constexpr uint16_t MaxWarmupThreads{ 8 };
+
+    /// Warmup maps the tables in the background, so the first probe of a table
+    /// in the search doesn't wait for the disk. It is stopped before the tables change.
+    struct Warmup {
+
+        ~Warmup() {
+            stop();
+        }
+
+        void stop() noexcept {
+            if (thread.joinable()) {
+                abort = true;
+                thread.join();
+            }
+            abort = false;
+            engine = nullptr;
+        }
+
+        std::thread thread;
+        std::atomic<bool> abort{ false };
+        Engine const *engine{ nullptr }; // Engine told of the progress
+    } TBWarmup;
+
+    /// readAhead() asks the system to read the table into the page cache, without waiting.
+    template<TBType Type>
+    uint64_t readAhead(TBTable<Type> const &e) noexcept {
+    #if defined(_WIN32)
+        (void)e;
+        return 0;
+    #else
+        // Mapping is the size of the file
+        if (e.baseAddress == nullptr
+         || e.mapping > WarmupReadSize) {
+            return 0;
+        }
+        #if defined(MADV_WILLNEED)
+        madvise(e.baseAddress, e.mapping, MADV_WILLNEED);
+        #endif
+        return e.mapping;
+    #endif
+    }
+
+    /// warmTables() maps the WDL and DTZ tables of up to the pieces, with a few threads,
+    /// and reports the progress every tenth of the tables.
+    void warmTables(int16_t pieceLimit, std::atomic<bool> const &abort, Engine const *engine) {
+        auto const startTime{ now() };
+
+        std::vector<size_t> tables;
+        for (size_t i = 0; i < TBTables.size(); ++i) {
+            // Code has a 'v' besides the pieces
+            if (int16_t(TBTables.code(i).size() - 1) <= pieceLimit) {
+                tables.push_back(i);
+            }
+        }
+        if (tables.empty()) {
+            return;
+        }
+
+        std::atomic<size_t> next{ 0 };
+        std::atomic<size_t> done{ 0 };
+        std::atomic<uint64_t> readSize{ 0 };
+        auto const work{ [&]() {
+            size_t t;
+            while (!abort.load(std::memory_order::memory_order_relaxed)
+                && (t = next.fetch_add(1, std::memory_order::memory_order_relaxed)) < tables.size()) {
+
+                StateInfo si;
+                Position pos;
+                pos.setup(TBTables.code(tables[t]), WHITE, si);
+
+                auto *const wdl{ TBTables.get<WDL>(pos.matlKey()) };
+                mapped(*wdl, pos);
+                readSize += readAhead(*wdl);
+                auto *const dtz{ TBTables.get<DTZ>(pos.matlKey()) };
+                mapped(*dtz, pos);
+                readSize += readAhead(*dtz);
+
+                auto const count{ ++done };
+                if (count * 10 / tables.size() != (count - 1) * 10 / tables.size()
+                 && count != tables.size()) {
+                    engine->message("Tablebases warm-up " + std::to_string(count) + "/" + std::to_string(tables.size()));
+                }
+            }
+        } };
+
+        auto const threadCount{ std::clamp(uint16_t(std::thread::hardware_concurrency()), uint16_t(1), MaxWarmupThreads) };
+        std::vector<std::thread> threads;
+        for (uint16_t i = 1; i < threadCount; ++i) {
+            threads.emplace_back(work);
+        }
+        work();
+        for (auto &th : threads) {
+            th.join();
+        }
+
+        std::ostringstream oss;
+        oss << "Tablebases warm-up " << (abort ? "aborted " : "done ")
+            << done << "/" << tables.size() << " tables, "
+            << readSize / (1024 * 1024) << " MB read ahead, "
+            << now() - startTime << " ms";
+        engine->message(oss.str());
+    }
+
+    /// cachedProbe() returns the result of the probe from the cache of the thread of the position,
+    /// else probes it and caches the result, timing the probe for the saved time to be estimated.
+    template<TBType Type, typename Probe>
+    int32_t cachedProbe(Position &pos, ProbeState &state, Probe probe) {
+        auto *const th{ pos.thread() };
+        if (th == nullptr
+         || BenchProbing) {
+            return probe();
+        }
+
+        auto &cache{ th->tbCache };
+        if (cache.generation != TBGeneration) {
+            cache.clear();
+            cache.generation = TBGeneration;
+        }
+
+        Key const key{ pos.posiKey() };
+        auto &e{ cache.entries[(uint32_t(key) ^ (Type == DTZ ? ProbeCache::Size / 2 : 0)) & (ProbeCache::Size - 1)] };
+        uint64_t data{ e.data };
+        if ((e.check ^ data) == key
+         && (data >> 40) == uint64_t(Type)) {
+            th->tbCacheHits.fetch_add(1, std::memory_order::memory_order_relaxed);
+            state = ProbeState(int8_t(data >> 32));
+            return int32_t(uint32_t(data));
+        }
+
+        auto const startTime{ std::chrono::steady_clock::now() };
+        auto const value{ probe() };
+        th->tbProbeTime.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count(), std::memory_order::memory_order_relaxed);
+        th->tbCacheMisses.fetch_add(1, std::memory_order::memory_order_relaxed);
+
+        data = uint64_t(uint32_t(value))
+             | uint64_t(uint8_t(state)) << 32
+             | uint64_t(Type) << 40;
+        e.data  = data;
+        e.check = key ^ data;
+        return value;
+    }
+
+    /// randomFEN() places the pieces of the table at random, either side strong and to move,
+    /// retrying until the side not to move is not in check.
+    std::string randomFEN(std::string const &code, PRNG &prng) {
+        auto const v{ code.find('v') };
+        while (true) {
+            bool const flip{ (prng.rand<uint8_t>() & 1) != 0 };
+            Color const stm{ (prng.rand<uint8_t>() & 1) != 0 ? WHITE : BLACK };
+
+            char board[SQUARES];
+            std::fill(board, board + SQUARES, ' ');
+            for (size_t i = 0; i < code.size(); ++i) {
+                if (i == v) {
+                    continue;
+                }
+                bool const white{ (i < v) != flip };
+                Square s;
+                do {
+                    s = Square(prng.rand<uint8_t>() % SQUARES);
+                } while (board[s] != ' '
+                      || (code[i] == 'P'
+                       && (sRank(s) == RANK_1 || sRank(s) == RANK_8)));
+                board[s] = white ? code[i] : char(std::tolower(code[i]));
+            }
+
+            std::ostringstream oss;
+            for (Rank r = RANK_8; r >= RANK_1; --r) {
+                int16_t empty{ 0 };
+                for (File f = FILE_A; f <= FILE_H; ++f) {
+                    auto const c{ board[makeSquare(f, r)] };
+                    if (c == ' ') {
+                        ++empty;
+                        continue;
+                    }
+                    if (empty != 0) {
+                        oss << empty;
+                        empty = 0;
+                    }
+                    oss << c;
+                }
+                if (empty != 0) {
+                    oss << empty;
+                }
+                if (r != RANK_1) {
+                    oss << '/';
+                }
+            }
+            oss << ' ' << toChar(stm) << " - - 0 1";
+
+            StateInfo si;
+            Position pos;
+            pos.setup(oss.str(), si, nullptr);
+            if ((pos.attackersTo(pos.square(~stm|KING)) & pos.pieces(stm)) == 0) {
+                return oss.str();
+            }
+        }
+    }
+
     template<TBType Type, typename Ret = typename TBTable<Type>::Ret>
-    Ret probeTable(Position const &pos, ProbeState &state, WDLScore wdl = WDL_DRAW) {
+    Ret lookupTable(Position const &pos, ProbeState &state, WDLScore wdl = WDL_DRAW) {
 
         // KvK
         //if (pos.count() == 2) {
@@ -1287,6 +1765,23 @@ namespace {
         return doProbeTable(pos, entry, wdl, state);
     }
 
+    template<TBType Type, typename Ret = typename TBTable<Type>::Ret>
+    Ret probeTable(Position const &pos, ProbeState &state, WDLScore wdl = WDL_DRAW) {
+    #if defined(USE_STATS)
+        Meter const meter;
+        auto const ret{ lookupTable<Type>(pos, state, wdl) };
+        auto const time{ meter.time() };
+        auto const faults{ meter.faults() };
+        if (pos.thread() != nullptr
+         && !BenchProbing) {
+            pos.thread()->tbStats.addProbe(Type == DTZ, pos.count(), time, faults);
+        }
+        return ret;
+    #else
+        return lookupTable<Type>(pos, state, wdl);
+    #endif
+    }
+
     /// For a position where the side to move has a winning capture it is not necessary
     /// to store a winning value so the generator treats such positions as "don't cares"
     /// and tries to assign to it a value that improves the compression ratio. Similarly,
@@ -1392,6 +1887,96 @@ namespace SyzygyTB {
         return ostream;
     }
 
+    void ProbeStats::clear() noexcept {
+        *this = {};
+    }
+
+    ProbeStats& ProbeStats::operator+=(ProbeStats const &stats) noexcept {
+        for (uint8_t t = 0; t < 2; ++t) {
+            for (int16_t p = 0; p <= TBPIECES; ++p) {
+                for (uint8_t b = 0; b < Buckets; ++b) {
+                    probeCounts[t][p][b] += stats.probeCounts[t][p][b];
+                }
+                probeTimes[t][p]    += stats.probeTimes[t][p];
+                probeMaxTimes[t][p]  = std::max(stats.probeMaxTimes[t][p], probeMaxTimes[t][p]);
+                probeFaults[t][p]   += stats.probeFaults[t][p];
+            }
+        }
+        mapCount  += stats.mapCount;
+        mapTime   += stats.mapTime;
+        mapMaxTime = std::max(stats.mapMaxTime, mapMaxTime);
+        mapFaults += stats.mapFaults;
+        return *this;
+    }
+
+    void ProbeStats::addProbe(bool dtz, int16_t pieces, uint64_t time, uint64_t faults) noexcept {
+        pieces = std::min(pieces, TBPIECES);
+        ++probeCounts[dtz][pieces][std::min(uint8_t(scanMSq(time | 1)), uint8_t(Buckets - 1))];
+        probeTimes[dtz][pieces]   += time;
+        probeMaxTimes[dtz][pieces] = std::max(time, probeMaxTimes[dtz][pieces]);
+        probeFaults[dtz][pieces]  += faults;
+    }
+
+    void ProbeStats::addMap(uint64_t time, uint64_t faults) noexcept {
+        ++mapCount;
+        mapTime   += time;
+        mapMaxTime = std::max(time, mapMaxTime);
+        mapFaults += faults;
+    }
+
+    /// ProbeStats::toString() returns the latencies in micro-seconds as a table, one line per table type and pieces.
+    /// The percentiles are the upper bounds of their buckets.
+    std::string ProbeStats::toString() const {
+        std::ostringstream oss;
+        oss << std::right << std::fixed << std::setprecision(2);
+
+        bool header{ false };
+        for (uint8_t t = 0; t < 2; ++t) {
+            for (int16_t p = 0; p <= TBPIECES; ++p) {
+                uint64_t count{ 0 };
+                for (uint8_t b = 0; b < Buckets; ++b) {
+                    count += probeCounts[t][p][b];
+                }
+                if (count == 0) {
+                    continue;
+                }
+
+                auto const percentile{ [&](uint64_t percent) {
+                    auto const rank{ (count * percent + 99) / 100 };
+                    uint64_t sum{ 0 };
+                    for (uint8_t b = 0; b < Buckets; ++b) {
+                        sum += probeCounts[t][p][b];
+                        if (sum >= rank) {
+                            return std::min(double(uint64_t(2) << b), double(probeMaxTimes[t][p])) / 1000;
+                        }
+                    }
+                    return double(probeMaxTimes[t][p]) / 1000;
+                } };
+
+                if (!header) {
+                    oss << "TB   Pieces     Probes    Mean us     P50 us     P90 us     P99 us     Max us  Faults\n";
+                    header = true;
+                }
+                oss << (t == 0 ? "WDL" : "DTZ")
+                    << std::setw(9) << p
+                    << std::setw(11) << count
+                    << std::setw(11) << double(probeTimes[t][p]) / count / 1000
+                    << std::setw(11) << percentile(50)
+                    << std::setw(11) << percentile(90)
+                    << std::setw(11) << percentile(99)
+                    << std::setw(11) << double(probeMaxTimes[t][p]) / 1000
+                    << std::setw(8) << probeFaults[t][p] << '\n';
+            }
+        }
+        if (mapCount != 0) {
+            oss << "TB mappings     :" << std::setw(16) << mapCount << '\n'
+                << "TB map mean (us):" << std::setw(16) << double(mapTime) / mapCount / 1000 << '\n'
+                << "TB map max (us) :" << std::setw(16) << double(mapMaxTime) / 1000 << '\n'
+                << "TB map faults   :" << std::setw(16) << mapFaults << '\n';
+        }
+        return oss.str();
+    }
+
     /// Probe the WDL table for a particular position.
     /// If state != PS_FAILURE, the probe was successful.
     /// The return value is from the point of view of the side to move:
@@ -1402,8 +1987,10 @@ namespace SyzygyTB {
     ///  2 : win
     WDLScore probeWDL(Position &pos, ProbeState &state) {
 
-        state = PS_SUCCESS;
-        return search(pos, state, false);
+        return WDLScore(cachedProbe<WDL>(pos, state, [&]() {
+            state = PS_SUCCESS;
+            return int32_t(search(pos, state, false));
+        }));
     }
 
     /// Probe the DTZ table for a particular position.
@@ -1431,7 +2018,7 @@ namespace SyzygyTB {
     ///
     /// In short, if a move is available resulting in dtz + 50-move-counter <= 99,
     /// then do not accept moves leading to dtz + 50-move-counter == 100.
-    int32_t probeDTZ(Position &pos, ProbeState &state) {
+    int32_t uncachedDTZ(Position &pos, ProbeState &state) {
 
         state = PS_SUCCESS;
         WDLScore wdlScore{ search(pos, state, true) };
@@ -1509,6 +2096,14 @@ namespace SyzygyTB {
         return minDTZ == 0xFFFF ? -1 : minDTZ;
     }
 
+    /// probeDTZ() probes the DTZ table through the cache of the thread, as probeWDL().
+    int32_t probeDTZ(Position &pos, ProbeState &state) {
+
+        return cachedProbe<DTZ>(pos, state, [&]() {
+            return uncachedDTZ(pos, state);
+        });
+    }
+
     constexpr int16_t wdlToRank[]
     {
         -1000,
@@ -1533,7 +2128,7 @@ namespace SyzygyTB {
     /// no moves were filtered out.
     bool rootProbeWDL(Position &rootPos, RootMoves &rootMoves) noexcept {
 
-        bool move50Rule{ Options["SyzygyMove50Rule"] };
+        bool move50Rule{ Options()["SyzygyMove50Rule"] };
 
         StateInfo si;
         ProbeState state;
@@ -1572,7 +2167,7 @@ namespace SyzygyTB {
         // Check whether a position was repeated since the last zeroing move.
         bool const repeated{ rootPos.repeated() };
 
-        int16_t bound( Options["SyzygyMove50Rule"] ? 900 : 1 );
+        int16_t bound( Options()["SyzygyMove50Rule"] ? 900 : 1 );
         int32_t dtz;
 
         StateInfo si;
@@ -1744,8 +2339,13 @@ namespace SyzygyTB {
             initialized = true;
         }
 
+        // Tables are going to be destroyed
+        TBWarmup.stop();
+        TBBlockCache.clear();
+
         TBTables.clear();
         MaxPieceLimit = 0;
+        ++TBGeneration;
 
         if (whiteSpaces(paths)) {
             return;
@@ -1803,6 +2403,133 @@ namespace SyzygyTB {
             }
         }
 
-        sync_cout << "info string Tablebases found " << TBTables.size() << sync_endl;
+        ActiveEngine->message("Tablebases found " + std::to_string(TBTables.size()));
+    }
+
+    /// warmup() starts mapping in the background the tables of up to the pieces (0 = none),
+    /// stopping a warm-up still running.
+    void warmup(int16_t pieceLimit) noexcept {
+        TBWarmup.stop();
+
+        pieceLimit = std::min(pieceLimit, MaxPieceLimit);
+        if (pieceLimit < 3) {
+            return;
+        }
+        TBWarmup.engine = ActiveEngine;
+        TBWarmup.thread = std::thread(warmTables, pieceLimit, std::cref(TBWarmup.abort), TBWarmup.engine);
+    }
+
+    /// detach() stops the warm-up telling its progress to the engine, before the engine goes.
+    void detach(Engine const *engine) noexcept {
+        if (TBWarmup.engine == engine) {
+            TBWarmup.stop();
+        }
+    }
+
+    /// resizeBlockCache() sets the memory in MB of the cache of the decoded blocks, 0 disables it.
+    void resizeBlockCache(uint32_t mbSize) {
+        TBBlockCache.resize(mbSize);
+    }
+
+    /// resetBlockCacheCounts() clears the counts of the lookups of the block cache, shared by all the engines.
+    void resetBlockCacheCounts() noexcept {
+        TBBlockCache.resetCounts();
+    }
+
+    std::string blockCacheInfo() {
+        return TBBlockCache.toString();
+    }
+
+    /// benchProbe() probes random endgames of the tables found with many threads at once,
+    /// first on the tables not mapped yet, then again on the same positions with the tables mapped.
+    /// Each thread probes WDL and DTZ alternately on its own positions, without the probe cache
+    /// so that the second pass measures the probes of the mapped tables.
+    /// With the block cache enabled, the warm pass runs without it and a last pass with it filled.
+    void benchProbe(uint16_t threadCount, uint32_t count) {
+        if (TBTables.size() == 0) {
+            std::cout << "No tablebases";
+            return;
+        }
+        threadCount = std::max(threadCount, uint16_t(1));
+        count = std::max(count, uint32_t(1));
+
+        auto *const engine{ ActiveEngine };
+
+        std::vector<std::vector<std::string>> fens(threadCount);
+        for (uint16_t t = 0; t < threadCount; ++t) {
+            PRNG prng{ 0x9E3779B97F4A7C15ULL * (t + 1) };
+            fens[t].reserve(count);
+            for (uint32_t i = 0; i < count; ++i) {
+                fens[t].push_back(randomFEN(TBTables.code(prng.rand<uint32_t>() % TBTables.size()), prng));
+            }
+        }
+
+        std::atomic<uint64_t> failCount{ 0 };
+        // Runs the probes on all the threads released together, returns the time in nano-seconds
+        auto const run{ [&]() {
+            std::atomic<uint16_t> waiting{ threadCount };
+            std::atomic<bool> go{ false };
+            std::vector<std::thread> threads;
+            for (uint16_t t = 0; t < threadCount; ++t) {
+                threads.emplace_back([&, t]() {
+                    EngineScope engineScope{ engine };
+                    // Only for the moves of the position, the cache and statistics of the thread are not used
+                    auto *const th{ Threadpool()[t % Threadpool().size()] };
+                    BenchProbing = true;
+
+                    --waiting;
+                    while (!go.load(std::memory_order::memory_order_acquire)) {
+                        std::this_thread::yield();
+                    }
+
+                    uint64_t fails{ 0 };
+                    for (uint32_t i = 0; i < count; ++i) {
+                        StateInfo si;
+                        Position pos;
+                        pos.setup(fens[t][i], si, th);
+                        ProbeState state;
+                        if ((i & 1) == 0) {
+                            probeWDL(pos, state);
+                        } else {
+                            probeDTZ(pos, state);
+                        }
+                        fails += state == PS_FAILURE;
+                    }
+                    failCount += fails;
+                });
+            }
+            while (waiting.load(std::memory_order::memory_order_acquire) != 0) {
+                std::this_thread::yield();
+            }
+            auto const startTime{ std::chrono::steady_clock::now() };
+            go.store(true, std::memory_order::memory_order_release);
+            for (auto &th : threads) {
+                th.join();
+            }
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+        } };
+
+        auto const probeCount{ uint64_t(threadCount) * count };
+        auto const cacheSize{ TBBlockCache.mbSize() };
+        TBBlockCache.resize(0);
+        auto const coldTime{ run() };
+        auto const warmTime{ run() };
+
+        std::cout << "Tablebases: " << TBTables.size() << " threads: " << threadCount << " probes: " << probeCount << " failed: " << failCount / 2 << '\n'
+                  << "cold ns/probe: " << std::setw(6) << coldTime / probeCount << " ms: " << coldTime / 1000000 << '\n'
+                  << "warm ns/probe: " << std::setw(6) << warmTime / probeCount << " ms: " << warmTime / 1000000;
+
+        if (cacheSize != 0) {
+            TBBlockCache.resize(cacheSize);
+            // A block is decoded at its second miss
+            run();
+            run();
+            TBBlockCache.resetCounts();
+            auto const cachedTime{ run() };
+            std::cout << '\n'
+                      << "block cache ns/probe: " << std::setw(6) << cachedTime / probeCount << " ms: " << cachedTime / 1000000 << '\n'
+                      << "block cache " << TBBlockCache.toString();
+            TBBlockCache.resetCounts();
+        }
     }
 }
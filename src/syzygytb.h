@@ -8,6 +8,8 @@
 #include "rootmove.h"
 #include "type.h"
 
+class Engine;
+
 namespace SyzygyTB {
 
     constexpr int16_t TBPIECES{ 7 };
@@ -37,6 +39,53 @@ namespace SyzygyTB {
 
     extern int16_t MaxPieceLimit;
 
+    /// ProbeStats measures the probes of the tables by a thread, by table type (WDL/DTZ) and pieces:
+    /// latencies in logarithmic buckets with the major page faults, and the first-touch mappings.
+    /// The measuring is compiled in only with USE_STATS (make stats=yes).
+    struct ProbeStats final {
+
+        // Bucket b counts the probes of less than 2^(b+1) nano-seconds
+        static constexpr uint8_t Buckets{ 32 };
+
+        void clear() noexcept;
+        ProbeStats& operator+=(ProbeStats const&) noexcept;
+
+        void addProbe(bool dtz, int16_t pieces, uint64_t time, uint64_t faults) noexcept;
+        void addMap(uint64_t time, uint64_t faults) noexcept;
+
+        std::string toString() const;
+
+        uint64_t probeCounts[2][TBPIECES + 1][Buckets];
+        uint64_t probeTimes[2][TBPIECES + 1];
+        uint64_t probeMaxTimes[2][TBPIECES + 1];
+        uint64_t probeFaults[2][TBPIECES + 1];
+        uint64_t mapCount;
+        uint64_t mapTime;
+        uint64_t mapMaxTime;
+        uint64_t mapFaults;
+    };
+
+    /// ProbeCache keeps the recent WDL/DTZ results of the probes of a thread, direct mapped on the position key.
+    /// An entry stores its key xor-ed with its data, so an entry torn by a concurrent write is a miss.
+    struct ProbeCache final {
+
+        static constexpr uint32_t Size{ 0x1000 };
+
+        struct Entry {
+            Key      check; // Key ^ data
+            uint64_t data;  // Value, state and table type
+        };
+
+        void clear() noexcept {
+            for (auto &e : entries) {
+                e = Entry{};
+            }
+        }
+
+        Entry    entries[Size]{};
+        uint32_t generation{ 0 }; // Of the tables the results come from
+    };
+
     extern WDLScore probeWDL(Position&, ProbeState&);
     extern int32_t  probeDTZ(Position&, ProbeState&);
 
@@ -46,5 +95,14 @@ namespace SyzygyTB {
     extern void rankRootMoves(Position&, RootMoves&) noexcept;
 
     extern void initialize(std::string_view) noexcept;
+    extern void warmup(int16_t) noexcept;
+    extern void detach(Engine const*) noexcept;
+
+    extern void resizeBlockCache(uint32_t);
+    extern void resetBlockCacheCounts() noexcept;
+    extern std::string blockCacheInfo();
+
+    // Probes random endgames with the threads, the count of probes per thread
+    extern void benchProbe(uint16_t, uint32_t);
 
 }
@@ -1,24 +1,73 @@
 #include "thread.h"
 
 #include <cassert>
+#include <algorithm>
 #include <cmath>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
+#include <thread>
 #include <unordered_map>
 
+#if defined(_MSC_VER)
+    #include <intrin.h> // Microsoft header for _mm_pause()
+#endif
+
+#include "engine.h"
 #include "searcher.h"
 #include "syzygytb.h"
 #include "transposition.h"
 #include "uci.h"
 #include "helper/memoryhandler.h"
 
-ThreadPool Threadpool;
+namespace {
+
+    /// pause() hints the processor that it is in a spin-wait loop,
+    /// so it saves power and yields resources to the hyperthread sibling.
+    inline void pause() noexcept {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+        asm volatile("yield");
+#else
+        std::this_thread::yield();
+#endif
+    }
+
+    /// spinWait() polls the condition for up to the spin time, with exponential backoff
+    /// between the polls. Returns false if the time is up before the condition holds.
+    template<typename Condition>
+    bool spinWait(Condition condition) noexcept {
+        auto const spinTime{ Threadpool().spinTime.load(std::memory_order::memory_order_relaxed) };
+        if (spinTime == 0) {
+            return false;
+        }
+
+        auto const deadline{ std::chrono::steady_clock::now() + std::chrono::microseconds(spinTime) };
+        uint16_t pauses{ 1 };
+        while (!condition()) {
+            for (uint16_t i = 0; i < pauses; ++i) {
+                pause();
+            }
+            pauses = std::min(uint16_t(2 * pauses), uint16_t(64));
+            if (std::chrono::steady_clock::now() >= deadline) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
 
 /// Thread constructor launches the thread and waits until it goes to sleep in threadFunc().
 /// Note that 'busy' and 'dead' should be already set.
+/// The thread works for the engine active on the creating thread.
 Thread::Thread(uint16_t idx) :
     dead{ false },
     busy{ true },
     index{ idx },
+    engine{ ActiveEngine },
     nativeThread(&Thread::threadFunc, this) {
 
     waitIdle();
@@ -41,15 +90,30 @@ void Thread::wakeUp() {
 }
 
 /// Thread::waitIdle() blocks on the condition variable while the thread is busy.
+/// With spin time it first spins, to avoid sleeping if the thread is about to finish.
 void Thread::waitIdle() {
+    if (spinWait([this]{ return !busy; })) {
+        return;
+    }
     std::unique_lock<std::mutex> uniqueLock(mutex);
     condition.wait(uniqueLock, [this]{ return !busy; });
     //uniqueLock.unlock();
 }
 
+/// Thread::idle() checks if the thread has no work to do.
+bool Thread::idle() const noexcept {
+    return !busy;
+}
+
 /// Thread::threadFunc() is where the thread is parked.
 /// Blocked on the condition variable, when it has no work to do.
+/// With spin time it first spins, so a quick next 'go' wakes it without a futex wake-up.
 void Thread::threadFunc() {
+    ActiveEngine = engine;
+
+    // Place the thread as asked by the thread affinity policy
+    Affinity::bind(Threadpool().cpus, Threadpool().bindOffset + index);
+
     // If OS already scheduled us on a different group than 0 then don't overwrite
     // the choice, eventually we are one of many one-threaded processes running on
     // some Windows NUMA hardware, for instance in fishtest. To make it simple,
@@ -65,12 +129,16 @@ void Thread::threadFunc() {
         // Sleep down
         busy = false;
         condition.notify_one(); // Wake up anyone waiting for search finished
-        condition.wait(uniqueLock, [this]{ return busy; });
+        uniqueLock.unlock();
+        spinWait([this]{ return busy.load(std::memory_order::memory_order_acquire); });
+        uniqueLock.lock();
+        condition.wait(uniqueLock, [this]{ return busy.load(std::memory_order::memory_order_relaxed); });
         uniqueLock.unlock();
         if (dead) {
             return;
         }
 
+        wakeTime = std::chrono::steady_clock::now();
         search();
     }
 }
@@ -91,6 +159,7 @@ void Thread::clean() {
             continuationStats[inCheck][capture][NO_PIECE][0].fill(CounterMovePruneThreshold - 1);
         }
     }
+    tbCache.clear();
     //matlTable.clear();
     //pawnTable.clear();
     //kingTable.clear();
@@ -101,6 +170,7 @@ void MainThread::clean() {
     Thread::clean();
 
     tickCount = 0;
+    reportTime = now();
 }
 
 MainThread* ThreadPool::mainThread() const noexcept {
@@ -149,6 +219,57 @@ Thread* ThreadPool::bestThread() const noexcept {
     return bestTh;
 }
 
+/// ThreadPool::splitRootMoves() deals out the root moves by rank to the groups of the split MultiPV search,
+/// the thread of index i is in the group i % pvGroups. So each group has a share of the likely best moves.
+void ThreadPool::splitRootMoves() {
+    auto const rootMoves{ front()->rootMoves };
+    for (uint16_t i = 0; i < size(); ++i) {
+        auto *th{ at(i) };
+        th->rootMoves.clear();
+        for (size_t r = i % pvGroups; r < rootMoves.size(); r += pvGroups) {
+            th->rootMoves += rootMoves[r];
+        }
+    }
+}
+
+/// ThreadPool::mergedLines() merges the lines of the deepest thread of each group of the split MultiPV search.
+/// Returns the best pvCount lines and sets the depth of each.
+RootMoves ThreadPool::mergedLines(std::vector<Depth> &depths) const {
+    std::vector<std::pair<RootMove, Depth>> lines;
+    for (uint16_t g = 0; g < pvGroups; ++g) {
+        Thread *deepest{ nullptr };
+        Depth deepestDepth{ -1 };
+        for (uint16_t i = g; i < size(); i += pvGroups) {
+            std::lock_guard<std::mutex> lockGuard(at(i)->pvMutex);
+            if (deepestDepth < at(i)->pvDepth) {
+                deepestDepth = at(i)->pvDepth;
+                deepest = at(i);
+            }
+        }
+        std::lock_guard<std::mutex> lockGuard(deepest->pvMutex);
+        for (auto const &rm : deepest->pvLines) {
+            lines.emplace_back(rm, deepest->pvDepth);
+        }
+    }
+    // Best value first, then deeper line first
+    std::stable_sort(lines.begin(), lines.end(), [](auto const &l1, auto const &l2) {
+        return l1.first < l2.first
+            || (!(l2.first < l1.first)
+             && l1.second > l2.second);
+    });
+    if (lines.size() > pvCount) {
+        lines.erase(lines.begin() + pvCount, lines.end());
+    }
+
+    RootMoves rootMoves;
+    depths.clear();
+    for (auto const &line : lines) {
+        rootMoves += line.first;
+        depths.push_back(line.second);
+    }
+    return rootMoves;
+}
+
 /// ThreadPool::setSize() creates/destroys threads to match the threadCount.
 /// Created and launched threads will immediately go to sleep in threadFunc.
 /// Upon resizing, threads are recreated to allow for binding if necessary.
@@ -170,7 +291,7 @@ void ThreadPool::setup(uint16_t threadCount) {
 
         clean();
         // Reallocate the hash with the new threadpool size
-        TT.autoResize(Options["Hash"]);
+        TT().autoResize(Options()["Hash"]);
         Searcher::initialize();
     }
 }
@@ -194,7 +315,7 @@ void ThreadPool::startThinking(Position &pos, StateListPtr &states) {
 
     stopPonderhit = false;
 
-    RootMoves rootMoves{ pos, Limits.searchMoves };
+    RootMoves rootMoves{ pos, Limits().searchMoves };
 
     if (!rootMoves.empty()) {
         SyzygyTB::rankRootMoves(pos, rootMoves);
@@ -219,10 +340,28 @@ void ThreadPool::startThinking(Position &pos, StateListPtr &states) {
         th->finishedDepth = DEPTH_ZERO;
         th->nodes         = 0;
         th->tbHits        = 0;
+        th->tbCacheHits   = 0;
+        th->tbCacheMisses = 0;
+        th->tbProbeTime   = 0;
         th->pvChanges     = 0;
         th->nmpMinPly     = 0;
         th->nmpColor      = COLORS;
         th->rootMoves     = rootMoves;
+        th->syncNodes     = SyncNodes;
+        th->syncedNodes   = 0;
+        th->atSync        = false;
+        {
+            // Lines of the last search must not be merged before the thread starts this one
+            std::lock_guard<std::mutex> lockGuard(th->pvMutex);
+            th->pvLines.clear();
+            th->pvDepth   = DEPTH_ZERO;
+        }
+        th->stats.clear();
+        th->tbStats.clear();
+        if (deterministic) {
+            th->ttBuffer.resize(8 * SyncNodes);
+            th->ttBuffer.clear();
+        }
         th->rootPos.setup(fen, th->rootState, th);
         assert(th->rootState.pawnKey == setupStates->back().pawnKey);
         assert(th->rootState.matlKey == setupStates->back().matlKey);
@@ -231,14 +370,32 @@ void ThreadPool::startThinking(Position &pos, StateListPtr &states) {
         th->rootState     = setupStates->back();
     }
 
+    syncThreads.clear();
+    syncCount   = uint16_t(size());
+    syncLeaders = 0;
+    syncArrived = 0;
+    syncPhase   = 0;
+    syncStop    = false;
+    syncedNodes = 0;
+
+    goTime = std::chrono::steady_clock::now();
     mainThread()->wakeUp();
 }
 
 void ThreadPool::stopThinking() {
-    stop = true;
+    raiseStop();
     mainThread()->waitIdle();
 }
 
+/// ThreadPool::releaseStates() gives back the setup states of the last search, if it is finished,
+/// for the moves of the next position to be played on them.
+StateListPtr ThreadPool::releaseStates() noexcept {
+    if (!mainThread()->idle()) {
+        return StateListPtr{};
+    }
+    return std::move(setupStates);
+}
+
 void ThreadPool::wakeUpAll() {
     for (auto *th : *this) {
         if (th != front()) {
@@ -254,6 +411,261 @@ void ThreadPool::waitIdleAll() {
     }
 }
 
+/// ThreadPool::raiseStop() raises the stop, recording the time if not already raised.
+/// The search ending on its own (depth or mate reached) does not record it, to measure only the stops asked.
+void ThreadPool::raiseStop(bool timed) noexcept {
+    if (!stop.exchange(true)
+     && timed) {
+        stopTime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+/// ThreadPool::synchronize() is the sync point of the deterministic search, the thread reaches it every SyncNodes nodes.
+/// Once all the searching threads are there, the limits are checked and then each thread flushes
+/// its part of the table from the buffers of all, so the table is updated in the same order every time.
+void ThreadPool::synchronize(Thread *th) {
+    std::unique_lock<std::mutex> uniqueLock(syncMutex);
+    th->syncedNodes = th->nodes;
+    th->atSync = true;
+
+    auto phase{ syncPhase };
+    if (++syncArrived == syncCount) {
+        completeSync();
+    } else {
+        syncCondition.wait(uniqueLock, [&]{ return syncPhase != phase; });
+    }
+    auto const part{ uint16_t(std::find(syncThreads.begin(), syncThreads.end(), th) - syncThreads.begin()) };
+    auto const partCount{ uint16_t(syncThreads.size()) };
+    uniqueLock.unlock();
+
+    for (auto const *t : syncThreads) {
+        TT().flush(t->ttBuffer, part, partCount);
+    }
+
+    // Wait for all the parts flushed before reusing the buffer
+    uniqueLock.lock();
+    phase = syncPhase;
+    if (++syncArrived == partCount) {
+        syncArrived = 0;
+        ++syncPhase;
+        syncCondition.notify_all();
+    } else {
+        syncCondition.wait(uniqueLock, [&]{ return syncPhase != phase; });
+    }
+    uniqueLock.unlock();
+
+    th->ttBuffer.clear();
+    th->atSync = false;
+    th->syncNodes = th->nodes + SyncNodes;
+}
+
+/// ThreadPool::leaveSync() removes the thread finishing its search from the sync points.
+/// Once the first threads of all the groups have finished, the stop of the others is requested.
+void ThreadPool::leaveSync(bool leader) {
+    std::lock_guard<std::mutex> lockGuard(syncMutex);
+    if (leader
+     && ++syncLeaders == pvGroups) {
+        syncStop = true;
+    }
+    if (--syncCount != 0
+     && syncArrived == syncCount) {
+        completeSync();
+    }
+}
+
+/// ThreadPool::requestStop() requests the stop of the deterministic search,
+/// raised at the next sync point so that all the threads stop at the same nodes.
+void ThreadPool::requestStop() {
+    std::lock_guard<std::mutex> lockGuard(syncMutex);
+    syncStop = true;
+}
+
+/// ThreadPool::completeSync() is run by the last thread arriving at the sync point, under the lock.
+/// The nodes of all the threads are known exactly here, so the node limit is checked against them.
+void ThreadPool::completeSync() {
+    syncThreads.clear();
+    for (auto *th : *this) {
+        if (th->atSync) {
+            syncThreads.push_back(th);
+        }
+    }
+    syncedNodes = accumulate(&Thread::nodes);
+    // Stop requested by the search itself (mate found) is not timed
+    if (syncStop
+     || (Limits().nodes != 0
+      && Limits().nodes <= syncedNodes)) {
+        raiseStop(!syncStop);
+    }
+    syncArrived = 0;
+    ++syncPhase;
+    syncCondition.notify_all();
+}
+
+/// ThreadPool::flushBuffers() flushes the buffers left at the end of the deterministic search, in thread order.
+void ThreadPool::flushBuffers() {
+    for (auto *th : *this) {
+        TT().flush(th->ttBuffer, 0, 1);
+        th->ttBuffer.clear();
+        th->syncedNodes = th->nodes;
+    }
+    syncedNodes = accumulate(&Thread::nodes);
+}
+
+/// ThreadPool::wakeUpLatency() returns the average latency, in micro-seconds, from 'go' to the threads
+/// starting the search, and sets the max latency. Threads not woken since 'go' are skipped.
+uint64_t ThreadPool::wakeUpLatency(uint64_t &maxLatency) const noexcept {
+    uint64_t sumLatency{ 0 };
+    uint16_t count{ 0 };
+    maxLatency = 0;
+    for (auto const *th : *this) {
+        if (th->wakeTime < goTime) {
+            continue;
+        }
+        uint64_t const latency(std::chrono::duration_cast<std::chrono::microseconds>(th->wakeTime - goTime).count());
+        sumLatency += latency;
+        maxLatency = std::max(latency, maxLatency);
+        ++count;
+    }
+    return count != 0 ? sumLatency / count : 0;
+}
+
+void LatencyHistogram::clear() noexcept {
+    std::fill_n(counts, Buckets, 0);
+    count = 0;
+    sum = 0;
+    max = 0;
+}
+
+void LatencyHistogram::add(int64_t latency) noexcept {
+    latency = std::max(latency, int64_t(0));
+    counts[std::upper_bound(Bounds, Bounds + Buckets - 1, latency) - Bounds] += 1;
+    count += 1;
+    sum += latency;
+    max = std::max(latency, max);
+}
+
+/// LatencyHistogram::toString() returns the count, mean, max and the non-empty buckets.
+std::string LatencyHistogram::toString() const {
+    std::ostringstream oss;
+    oss << "count " << count
+        << " mean " << (count != 0 ? sum / count : 0) << "us"
+        << " max " << max << "us";
+    for (uint8_t b = 0; b < Buckets; ++b) {
+        if (counts[b] != 0) {
+            oss << (b < Buckets - 1 ? " <" : " >=")
+                << Bounds[std::min(b, uint8_t(Buckets - 2))] << "us:" << counts[b];
+        }
+    }
+    return oss.str();
+}
+
+void SearchStats::clear() noexcept {
+    *this = {};
+}
+
+SearchStats& SearchStats::operator+=(SearchStats const &stats) noexcept {
+    depthNodes      += stats.depthNodes;
+    quienNodes      += stats.quienNodes;
+    ttCutoffs       += stats.ttCutoffs;
+    quienTTCutoffs  += stats.quienTTCutoffs;
+    nullMoveTries   += stats.nullMoveTries;
+    nullMoveCutoffs += stats.nullMoveCutoffs;
+    probCutTries    += stats.probCutTries;
+    probCutCutoffs  += stats.probCutCutoffs;
+    lmrSearches     += stats.lmrSearches;
+    lmrResearches   += stats.lmrResearches;
+    for (Depth d = 0; d < MaxDepth; ++d) {
+        failHighs[d]      += stats.failHighs[d];
+        failHighsFirst[d] += stats.failHighsFirst[d];
+    }
+    return *this;
+}
+
+/// SearchStats::toString() returns the rates of the statistics as a table, one line per depth for the fail highs.
+std::string SearchStats::toString() const {
+    auto const percent{ [](uint64_t part, uint64_t whole) {
+        return whole != 0 ? 100.0 * part / whole : 0.0;
+    } };
+
+    std::ostringstream oss;
+    oss << std::right << std::fixed << std::setprecision(2)
+        << "Nodes           :" << std::setw(16) << depthNodes + quienNodes << '\n'
+        << "QSearch nodes  %:" << std::setw(16) << percent(quienNodes, depthNodes + quienNodes) << '\n'
+        << "TT cutoffs     %:" << std::setw(16) << percent(ttCutoffs, depthNodes) << '\n'
+        << "QS TT cutoffs  %:" << std::setw(16) << percent(quienTTCutoffs, quienNodes) << '\n'
+        << "Null moves     %:" << std::setw(16) << percent(nullMoveTries, depthNodes) << '\n'
+        << "Null cutoffs   %:" << std::setw(16) << percent(nullMoveCutoffs, nullMoveTries) << '\n'
+        << "ProbCuts       %:" << std::setw(16) << percent(probCutTries, depthNodes) << '\n'
+        << "ProbCut cutoffs%:" << std::setw(16) << percent(probCutCutoffs, probCutTries) << '\n'
+        << "LMR searches    :" << std::setw(16) << lmrSearches << '\n'
+        << "LMR re-searches%:" << std::setw(16) << percent(lmrResearches, lmrSearches) << '\n'
+        << "Depth  Fail highs  First move %\n";
+    for (Depth d = 1; d < MaxDepth; ++d) {
+        if (failHighs[d] != 0) {
+            oss << (d < MaxDepth - 1 ? " " : ">") << std::setw(4) << d
+                << std::setw(12) << failHighs[d]
+                << std::setw(14) << percent(failHighsFirst[d], failHighs[d]) << '\n';
+        }
+    }
+    return oss.str();
+}
+
+StopTimer::~StopTimer() {
+    if (thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lockGuard(mutex);
+            dead = true;
+        }
+        condition.notify_one();
+        thread.join();
+    }
+}
+
+/// StopTimer::arm() sets the deadline, the timer thread is launched on first use.
+void StopTimer::arm(std::chrono::steady_clock::time_point dl) {
+    {
+        std::lock_guard<std::mutex> lockGuard(mutex);
+        deadline = dl;
+        armed = true;
+    }
+    if (!thread.joinable()) {
+        thread = std::thread(
+            [this, engine = ActiveEngine]() {
+                ActiveEngine = engine;
+                timerFunc();
+            });
+    }
+    condition.notify_one();
+}
+
+void StopTimer::disarm() {
+    std::lock_guard<std::mutex> lockGuard(mutex);
+    armed = false;
+}
+
+/// StopTimer::timerFunc() sleeps until the deadline then raises the stop.
+/// While pondering the stop is held back, until "ponderhit" or "stop".
+void StopTimer::timerFunc() {
+    std::unique_lock<std::mutex> uniqueLock(mutex);
+    while (!dead) {
+        if (!armed) {
+            condition.wait(uniqueLock);
+            continue;
+        }
+        if (std::chrono::steady_clock::now() < deadline) {
+            condition.wait_until(uniqueLock, deadline);
+            continue;
+        }
+        if (Threadpool().ponder) {
+            condition.wait_for(uniqueLock, std::chrono::milliseconds(1));
+            continue;
+        }
+        armed = false;
+        Threadpool().raiseStop();
+    }
+}
+
 /// Used to serialize access to std::cout to avoid multiple threads writing at the same time.
 std::ostream& operator<<(std::ostream &ostream, OutputState outputState) {
     static std::mutex mutex;
@@ -2,8 +2,11 @@
 
 #include <array>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <mutex>
+#include <string>
+#include <thread>
 #include <vector>
 
 #include "thread_win32_osx.h"
@@ -11,11 +14,56 @@
 #include "movepicker.h"
 #include "position.h"
 #include "rootmove.h"
+#include "syzygytb.h"
 #include "king.h"
 #include "material.h"
 #include "pawns.h"
+#include "transposition.h"
 #include "type.h"
 
+class Engine;
+
+// Nodes each thread searches between two sync points of the deterministic search
+constexpr uint64_t SyncNodes{ 0x400 };
+
+/// SearchStats counts the events of the search of one thread, so without contention.
+/// The counting is compiled in only with USE_STATS (make stats=yes).
+struct SearchStats final {
+
+    // Fail highs deeper than this are counted on the last depth
+    static constexpr Depth MaxDepth{ 32 };
+
+    void clear() noexcept;
+    SearchStats& operator+=(SearchStats const&) noexcept;
+
+    void failHigh(Depth depth, bool firstMove) noexcept {
+        depth = std::min(depth, Depth(MaxDepth - 1));
+        ++failHighs[depth];
+        failHighsFirst[depth] += firstMove;
+    }
+
+    std::string toString() const;
+
+    uint64_t depthNodes;
+    uint64_t quienNodes;
+    uint64_t ttCutoffs;
+    uint64_t quienTTCutoffs;
+    uint64_t nullMoveTries;
+    uint64_t nullMoveCutoffs;
+    uint64_t probCutTries;
+    uint64_t probCutCutoffs;
+    uint64_t lmrSearches;
+    uint64_t lmrResearches;
+    uint64_t failHighs[MaxDepth];
+    uint64_t failHighsFirst[MaxDepth];
+};
+
+#if defined(USE_STATS)
+    #define STATS(expr) (expr)
+#else
+    #define STATS(expr)
+#endif
+
 /// Thread class keeps together all the thread-related stuff.
 /// It use pawn and material hash tables so that once get a pointer to
 /// an entry its life time is unlimited and we don't have to care about
@@ -36,6 +84,7 @@ public:
 
     void wakeUp();
     void waitIdle();
+    bool idle() const noexcept;
 
     void threadFunc();
 
@@ -49,6 +98,7 @@ public:
     //uint16_t pvBeg;
     uint16_t pvCur;
     uint16_t pvEnd;
+    uint16_t pvCount;
 
     Position  rootPos;
     StateInfo rootState;
@@ -57,11 +107,32 @@ public:
     Depth rootDepth,
           finishedDepth,
           selDepth;
+    // Generation of the hash this search saves the entries with
+    uint8_t ttGeneration;
 
     std::atomic<uint64_t> nodes;
     std::atomic<uint64_t> tbHits;
+    // Tablebase probes answered by the cache and not, with the time of the latter in nano-seconds
+    std::atomic<uint64_t> tbCacheHits;
+    std::atomic<uint64_t> tbCacheMisses;
+    std::atomic<uint64_t> tbProbeTime;
     std::atomic<uint32_t> pvChanges;
 
+    // Time the thread woke up to search, to measure the wake-up latency
+    std::chrono::steady_clock::time_point wakeTime;
+
+    // Deterministic search: nodes at the next sync point and at the last one,
+    // and the hash entries probed since the last one
+    uint64_t syncNodes;
+    uint64_t syncedNodes;
+    TBuffer  ttBuffer;
+    bool     atSync;
+
+    // Split MultiPV: the lines of the last finished iteration, merged with the other groups
+    std::mutex pvMutex;
+    RootMoves  pvLines;
+    Depth      pvDepth;
+
     int16_t nmpMinPly;
     Color   nmpColor;
 
@@ -71,6 +142,11 @@ public:
 
     int16_t failHighCount;
 
+    SearchStats stats;
+
+    SyzygyTB::ProbeCache tbCache;
+    SyzygyTB::ProbeStats tbStats;
+
     // mainStats records how often quiet moves have been successful/unsuccessful
     // during the current search, and is used for reduction and move ordering decisions.
     ButterFlyStatsTable         mainStats;
@@ -96,8 +172,9 @@ private:
     std::mutex mutex;
     std::condition_variable condition;
     bool dead;
-    bool busy;
+    std::atomic<bool> busy; // Atomic to be polled while spinning
     uint16_t index; // indentity
+    Engine *engine; // Engine the thread works for
     NativeThread nativeThread;
 };
 
@@ -122,9 +199,58 @@ public:
     void search() final;
 
     int16_t tickCount;
+    TimePoint reportTime;
 };
 
 
+/// LatencyHistogram counts latencies in micro-seconds into logarithmic buckets.
+struct LatencyHistogram final {
+
+    static constexpr uint8_t Buckets{ 10 };
+    // Upper bounds of the buckets, the last bucket is unbounded
+    static constexpr int64_t Bounds[Buckets - 1]{ 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000 };
+
+    void clear() noexcept;
+    void add(int64_t) noexcept;
+
+    std::string toString() const;
+
+    uint32_t counts[Buckets];
+    uint32_t count;
+    int64_t  sum;
+    int64_t  max;
+};
+
+/// StopTimer is a dedicated thread that raises the stop at the hard deadline of the search,
+/// so stopping doesn't depend on the main thread polling the time every tickCount nodes.
+class StopTimer final {
+
+public:
+
+    StopTimer() = default;
+    ~StopTimer();
+
+    StopTimer(StopTimer const&) = delete;
+    StopTimer(StopTimer&&) = delete;
+
+    StopTimer& operator=(StopTimer const&) = delete;
+    StopTimer& operator=(StopTimer&&) = delete;
+
+    void arm(std::chrono::steady_clock::time_point);
+    void disarm();
+
+private:
+
+    void timerFunc();
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::chrono::steady_clock::time_point deadline;
+    bool armed{ false };
+    bool dead{ false };
+    std::thread thread;
+};
+
 /// ThreadPool class handles all the threads related stuff like,
 /// initializing & deinitializing, starting, parking & launching a thread
 /// All the access to shared thread data is done through this class.
@@ -159,16 +285,53 @@ public:
     MainThread* mainThread() const noexcept;
     Thread* bestThread() const noexcept;
 
+    void splitRootMoves();
+    RootMoves mergedLines(std::vector<Depth>&) const;
+
     void setup(uint16_t);
     void clean();
 
     void startThinking(Position&, StateListPtr&);
     void stopThinking();
 
+    StateListPtr releaseStates() noexcept;
+
     void wakeUpAll();
     void waitIdleAll();
 
+    void raiseStop(bool = true) noexcept;
+
+    void synchronize(Thread*);
+    void leaveSync(bool);
+    void requestStop();
+    void flushBuffers();
+
+    uint64_t wakeUpLatency(uint64_t&) const noexcept;
+
     uint16_t pvCount;
+    // Groups of threads of the split MultiPV search, 1 if not split
+    uint16_t pvGroups;
+
+    // Logical processors the thread affinity policy places the threads on, in order
+    std::vector<uint16_t> cpus;
+    // First processor the thread affinity policy places the threads from,
+    // for engines running side by side in one process
+    uint16_t bindOffset;
+
+    // Time in micro-seconds an idle thread spins before blocking (0 = block at once)
+    std::atomic<uint32_t> spinTime;
+
+    std::chrono::steady_clock::time_point goTime;
+
+    StopTimer stopTimer;
+    // Time the stop was raised, in nano-seconds of the steady clock
+    std::atomic<int64_t> stopTime;
+
+    LatencyHistogram stopLatency;       // From the stop raised to the bestmove
+    LatencyHistogram deadlineLatency;   // From the hard deadline to the bestmove, if passed
+
+    SearchStats searchStats;    // Sum of the statistics of the searches, since cleared
+    SyzygyTB::ProbeStats tbStats;
 
     std::atomic<bool> stop;     // Stop searching forcefully
     std::atomic<bool> stand;    // Stop increasing depth
@@ -185,13 +348,38 @@ public:
     std::array<Value, 4> iterValues;
     int16_t iterIdx;
 
+    // Reductions by depth and move count, depend on the number of threads
+    int32_t reductions[MAX_MOVES];
+
+    // Tablebase settings of the current search
+    Depth   tbDepthLimit;
+    int16_t tbPieceLimit;
+    bool    tbMove50Rule;
+    bool    tbHasRoot;
+
+    // Deterministic search: the threads meet every SyncNodes nodes to share their hash entries
+    // and check the limits, so the result depends only on the position and the threads count
+    bool     deterministic;
+    uint64_t syncedNodes; // Nodes of all the threads at the last sync point
+
 private:
 
+    void completeSync();
+
     StateListPtr setupStates;
+
+    std::mutex syncMutex;
+    std::condition_variable syncCondition;
+    std::vector<Thread*> syncThreads; // Threads at the sync point, in index order
+    uint16_t syncCount;   // Threads still searching
+    uint16_t syncLeaders; // First threads of the groups finished
+    uint16_t syncArrived; // Threads arrived at the sync point
+    uint32_t syncPhase;
+    bool     syncStop;    // Stop requested, raised at the next sync point
 };
 
-// Global ThreadPool
-extern ThreadPool Threadpool;
+// ThreadPool of the active engine
+extern ThreadPool& Threadpool() noexcept;
 
 /// Pre-loads the given address in L1/L2 cache.
 /// This is a non-blocking function that doesn't stall the CPU
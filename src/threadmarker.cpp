@@ -1,24 +1,19 @@
 #include "threadmarker.h"
 
-namespace {
-
-    constexpr uint16_t ThreadMarkSize{ 0x400 };
-
-    ThreadMark ThreadMarks[ThreadMarkSize];
-
-}
-
+#include "engine.h"
 
 ThreadMarker::ThreadMarker(Thread const *thread, Key posiKey, int16_t ply) noexcept :
     marked{ false },
     owned{ false },
     threadMark{ nullptr } {
 
-    if (ply >= 8) {
+    // Marks of the other threads depend on the scheduling
+    if (ply >= 8
+     || Threadpool().deterministic) {
         return;
     }
 
-    threadMark = &ThreadMarks[posiKey & (ThreadMarkSize - 1)];
+    threadMark = &ActiveEngine->threadMarks[posiKey & (ThreadMarkSize - 1)];
     // Check if another already marked it, if not, mark it
     auto *th{ threadMark->load(&ThreadMark::thread) };
     if (th == nullptr) {
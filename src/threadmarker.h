@@ -5,6 +5,8 @@
 #include "thread.h"
 #include "type.h"
 
+constexpr uint16_t ThreadMarkSize{ 0x400 };
+
 /// ThreadMark are used to mark nodes as being searched by a given thread
 struct ThreadMark {
 
@@ -10,7 +10,7 @@ class TimeManager {
 
 public:
 
-    constexpr TimeManager() noexcept;
+    TimeManager() noexcept;
     TimeManager(TimeManager const&) = delete;
     TimeManager(TimeManager&&) = delete;
 
@@ -26,7 +26,7 @@ public:
     /// TimeManager::elapsed()
     TimePoint elapsed() const noexcept {
         return(timeNodes == 0 ?
-            now() - startTime : Threadpool.accumulate(&Thread::nodes));
+            now() - startTime : Threadpool().accumulate(&Thread::nodes));
     }
 
     void clear() noexcept {
@@ -47,5 +47,5 @@ private:
     TimePoint maximumTime;
 };
 
-// Global Time Manager
-extern TimeManager TimeMgr;
+// Time Manager of the active engine
+extern TimeManager& TimeMgr() noexcept;
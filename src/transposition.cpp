@@ -8,42 +8,51 @@
 #include <thread>
 #include <vector>
 
+#include "engine.h"
 #include "movegenerator.h"
 #include "thread.h"
 #include "uci.h"
 #include "helper/string_view.h"
 #include "helper/memoryhandler.h"
 
-TTable TT;
-
-uint8_t TEntry::Generation{ 0 };
-
 /// TCluster::probe()
 /// If the position is found, it returns true and a pointer to the found entry.
 /// Otherwise, it returns false and a pointer to an empty or least valuable entry to be replaced later.
-TEntry* TCluster::probe(const uint16_t key16, bool &hit) noexcept {
+TEntry* TCluster::probe(const uint16_t key16, uint8_t gen, bool &hit) noexcept {
     // Find an entry to be replaced according to the replacement strategy.
     auto *rte{ entry }; // Default first
     for (auto *ite{ entry }; ite != entry + EntryPerCluster; ++ite) {
         if (ite->k16 == key16
          || ite->d08 == 0) {
             // Refresh entry
-            ite->refresh();
+            ite->refresh(gen);
             return hit = ite->d08 != 0, ite;
         }
         // Replacement strategy
-        if (rte->worth() > ite->worth()) {
+        if (rte->worth(gen) > ite->worth(gen)) {
             rte = ite;
         }
     }
     return hit = false, rte;
 }
 
+/// TCluster::find() looks up the entry of the key without refreshing it, nullptr if not found.
+TEntry const* TCluster::find(const uint16_t key16) const noexcept {
+    for (auto const *ite{ entry }; ite != entry + EntryPerCluster; ++ite) {
+        if (ite->k16 == key16
+         && ite->d08 != 0) {
+            return ite;
+        }
+    }
+    return nullptr;
+}
+
 
-constexpr TTable::TTable() noexcept :
+TTable::TTable() noexcept :
     clusterTable{ nullptr },
     clusterCount{ 0 },
-    hashfulCount{ 0 } {
+    hashfulCount{ 0 },
+    gen08{ 0 } {
 }
 
 TTable::~TTable() noexcept {
@@ -79,7 +88,7 @@ bool TTable::resize(size_t memSize) {
 
 /// TTable::autoResize() set size automatically
 void TTable::autoResize(size_t memSize) {
-    Threadpool.stopThinking();
+    Threadpool().stopThinking();
 
     auto mSize{ std::clamp(memSize, MinHashSize, MaxHashSize) };
     while (mSize >= MinHashSize) {
@@ -95,16 +104,18 @@ void TTable::clear() {
     assert(clusterTable != nullptr
         && clusterCount != 0);
 
-    if (Options["Retain Hash"]) {
+    if (Options()["Retain Hash"]) {
         return;
     }
 
     std::vector<std::thread> threads;
     auto const threadCount{ optionThreads() };
+    auto const &cpus{ Threadpool().cpus };
     for (uint16_t index = 0; index < threadCount; ++index) {
         threads.emplace_back(
-            [this, threadCount, index]() {
+            [this, &cpus, threadCount, index]() {
 
+                Affinity::bind(cpus, index);
                 if (threadCount > 8) {
                     WinProcGroup::bind(index);
                 }
@@ -140,7 +151,7 @@ void TTable::free() noexcept {
 uint32_t TTable::hashFull() const noexcept {
     uint32_t entryCount{ 0 };
     for (auto *itc{ clusterTable }; itc != clusterTable + hashfulCount; ++itc) {
-        entryCount += itc->freshEntryCount();
+        entryCount += itc->freshEntryCount(gen08);
     }
     return entryCount / TCluster::EntryPerCluster;
 }
@@ -168,6 +179,26 @@ Move TTable::extractNextMove(Position &pos, Move m) const noexcept {
     return nm;
 }
 
+/// TTable::flush() saves the entries of the buffer falling in the given part of the table.
+/// The parts don't share clusters, so each thread can flush its own part of all the buffers at the same time.
+void TTable::flush(TBuffer const &buffer, uint16_t part, uint16_t partCount) noexcept {
+    for (auto const s : buffer.usedSlots) {
+        auto const &slot{ buffer.slots[s] };
+        // Skip the entries never written, or overwritten through a stale pointer
+        if (slot.entry.d08 == 0
+         || slot.entry.k16 != uint16_t(slot.key)) {
+            continue;
+        }
+        auto const c{ mul_hi64(slot.key, clusterCount) };
+        if (c * partCount / clusterCount != part) {
+            continue;
+        }
+        auto &te{ slot.entry };
+        bool hit;
+        clusterTable[c].probe(te.k16, gen08, hit)->save(slot.key, te.move(), te.value(), te.eval(), te.depth(), te.bound(), te.isPV(), gen08);
+    }
+}
+
 /// TTable::save() saves hash to file
 void TTable::save(std::string_view hashFile) const {
     if (whiteSpaces(hashFile)) {
@@ -179,7 +210,7 @@ void TTable::save(std::string_view hashFile) const {
     }
     ofstream << *this;
     ofstream.close();
-    sync_cout << "info string Hash saved to file \'" << hashFile << "\'" << sync_endl;
+    ActiveEngine->message("Hash saved to file \'" + std::string(hashFile) + "\'");
 }
 /// TTable::load() loads hash from file
 void TTable::load(std::string_view hashFile) {
@@ -192,7 +223,51 @@ void TTable::load(std::string_view hashFile) {
     }
     ifstream >> *this;
     ifstream.close();
-    sync_cout << "info string Hash loaded from file \'" << hashFile << "\'" << sync_endl;
+    ActiveEngine->message("Hash loaded from file \'" + std::string(hashFile) + "\'");
+}
+
+/// TBuffer::resize() sets the number of slots, a power of 2.
+void TBuffer::resize(size_t slotCount) {
+    assert((slotCount & (slotCount - 1)) == 0);
+    if (slots.size() != slotCount) {
+        slots.assign(slotCount, Slot{});
+        usedSlots.clear();
+        usedSlots.reserve(slotCount / 2);
+    }
+}
+
+/// TBuffer::clear() empties the used slots.
+void TBuffer::clear() noexcept {
+    for (auto const s : usedSlots) {
+        slots[s] = Slot{};
+    }
+    usedSlots.clear();
+}
+
+/// TBuffer::probe() looks up the entry in the buffer, else copies it from the table into a free slot.
+/// The buffer is kept at most half full, beyond that the writes are dropped.
+TEntry* TBuffer::probe(const Key posiKey, bool &hit) noexcept {
+    assert(!slots.empty());
+
+    auto const mask{ slots.size() - 1 };
+    auto s{ size_t(posiKey) & mask };
+    while (slots[s].key != 0) {
+        if (slots[s].key == posiKey) {
+            return hit = slots[s].entry.d08 != 0, &slots[s].entry;
+        }
+        s = (s + 1) & mask;
+    }
+
+    if (usedSlots.size() >= slots.size() / 2) {
+        spare = TEntry{};
+        return hit = false, &spare;
+    }
+
+    slots[s].key = posiKey;
+    auto const *const tte{ TT().cluster(posiKey)->find(uint16_t(posiKey)) };
+    slots[s].entry = tte != nullptr ? *tte : TEntry{};
+    usedSlots.push_back(uint32_t(s));
+    return hit = tte != nullptr, &slots[s].entry;
 }
 
 namespace {
@@ -207,7 +282,7 @@ std::ostream& operator<<(std::ostream &ostream, TTable const &tt) {
     ostream.write(reinterpret_cast<char const*>(&dummy), sizeof(dummy));
     ostream.write(reinterpret_cast<char const*>(&dummy), sizeof(dummy));
     ostream.write(reinterpret_cast<char const*>(&dummy), sizeof(dummy));
-    ostream.write(reinterpret_cast<char const*>(&TEntry::Generation), sizeof(TEntry::Generation));
+    ostream.write(reinterpret_cast<char const*>(&tt.gen08), sizeof(tt.gen08));
     for (size_t i = 0; i < tt.clusterCount / BufferSize; ++i) {
         ostream.write(reinterpret_cast<char const*>(&tt.clusterTable[i*BufferSize]), sizeof(TCluster)*BufferSize);
     }
@@ -221,7 +296,7 @@ std::istream& operator>>(std::istream &istream, TTable       &tt) {
     istream.read(reinterpret_cast<char*>(&dummy), sizeof(dummy));
     istream.read(reinterpret_cast<char*>(&dummy), sizeof(dummy));
     istream.read(reinterpret_cast<char*>(&dummy), sizeof(dummy));
-    istream.read(reinterpret_cast<char*>(&TEntry::Generation), sizeof(TEntry::Generation));
+    istream.read(reinterpret_cast<char*>(&tt.gen08), sizeof(tt.gen08));
     tt.resize(memSize);
     for (size_t i = 0; i < tt.clusterCount / BufferSize; ++i) {
         istream.read(reinterpret_cast<char*>(&tt.clusterTable[i*BufferSize]), sizeof(TCluster)*BufferSize);
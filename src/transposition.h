@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <string_view>
+#include <vector>
 
 #include "position.h"
 #include "type.h"
@@ -44,11 +45,12 @@ public:
     // Due to packed storage format for generation and its cyclic nature
     // add 263 (256 + 7 [4 + BOUND_EXACT] to keep the unrelated lowest three bits from affecting the result)
     // to calculate the entry age correctly even after generation overflows into the next cycle.
-    int32_t      worth() const noexcept { return d08 - ((GENERATION_CYCLE + Generation - g08) & GENERATION_MASK); }
+    int32_t      worth(uint8_t gen) const noexcept { return d08 - ((GENERATION_CYCLE + gen - g08) & GENERATION_MASK); }
 
-    void       refresh() noexcept { g08 = uint8_t(Generation | (g08 & (GENERATION_DELTA - 1))); }
+    void       refresh(uint8_t gen) noexcept { g08 = uint8_t(gen | (g08 & (GENERATION_DELTA - 1))); }
 
-    void save(Key k, Move m, Value v, Value e, Depth d, Bound b, bool pv) noexcept {
+    /// save() saves the entry stamped with the given generation of the table.
+    void save(Key k, Move m, Value v, Value e, Depth d, Bound b, bool pv, uint8_t gen) noexcept {
 
         // Preserve any existing move for the same position
         if (m != MOVE_NONE
@@ -65,20 +67,13 @@ public:
 
             k16 = uint16_t(k);
             d08 = uint8_t(d - DEPTH_OFFSET);
-            g08 = uint8_t(Generation | uint8_t(pv) << 2 | b);
+            g08 = uint8_t(gen | uint8_t(pv) << 2 | b);
             v16 = int16_t(v);
             e16 = int16_t(e);
         }
         assert(d08 != 0);
     }
 
-    static void updateGeneration() noexcept {
-        Generation += GENERATION_DELTA;
-    }
-
-    // "Generation" variable distinguish transposition table entries from different searches.
-    static uint8_t Generation;
-
 private:
 
     uint16_t    k16;
@@ -89,6 +84,8 @@ private:
     int16_t     e16;
 
     friend struct TCluster;
+    friend class TBuffer;
+    friend class TTable;
 };
 /// Size of TEntry (10 bytes)
 static_assert(sizeof(TEntry) == 10, "Entry size incorrect");
@@ -97,15 +94,16 @@ static_assert(sizeof(TEntry) == 10, "Entry size incorrect");
 /// 10 x 3 + 2 = 32
 struct TCluster {
 
-    uint32_t freshEntryCount() const noexcept {
+    uint32_t freshEntryCount(uint8_t gen) const noexcept {
         return std::count_if(std::begin(entry), std::end(entry),
-            [](TEntry const &te) noexcept {
+            [gen](TEntry const &te) noexcept {
                 return te.d08 != 0
-                    && te.generation() == TEntry::Generation;
+                    && te.generation() == gen;
             });
     }
 
-    TEntry* probe(const uint16_t, bool&) noexcept;
+    TEntry* probe(const uint16_t, uint8_t, bool&) noexcept;
+    TEntry const* find(const uint16_t) const noexcept;
 
     static constexpr uint8_t EntryPerCluster{ 3 };
 
@@ -120,11 +118,13 @@ static_assert(sizeof(TCluster) == 32, "Cluster size incorrect");
 /// Each TTEntry contains information on exactly one position.
 /// The size of a Cluster should divide the size of a cache line for best performance,
 /// as the cacheline is prefetched when possible.
+class TBuffer;
+
 class TTable final {
 
 public:
 
-    constexpr TTable() noexcept;
+    TTable() noexcept;
     TTable(TTable const&) = delete;
     TTable(TTable&&) = delete;
     ~TTable() noexcept;
@@ -145,10 +145,15 @@ public:
     TCluster* cluster(const Key) const noexcept;
     TEntry* probe(const Key, bool&) const noexcept;
 
+    uint8_t generation() const noexcept;
+    void updateGeneration() noexcept;
+
     uint32_t hashFull() const noexcept;
 
     Move extractNextMove(Position&, Move) const noexcept;
 
+    void flush(TBuffer const&, uint16_t, uint16_t) noexcept;
+
     void save(std::string_view) const;
     void load(std::string_view);
 
@@ -167,6 +172,9 @@ private:
     size_t    clusterCount;
     size_t    hashfulCount;
 
+    // "Generation" variable distinguish transposition table entries from different searches.
+    uint8_t   gen08;
+
     friend std::ostream& operator<<(std::ostream&, TTable const&);
     friend std::istream& operator>>(std::istream&, TTable      &);
 };
@@ -194,11 +202,44 @@ inline TCluster* TTable::cluster(const Key posiKey) const noexcept {
 }
 /// TTable::probe() looks up the entry in the transposition table.
 inline TEntry* TTable::probe(const Key posiKey, bool &hit) const noexcept {
-    return cluster(posiKey)->probe(uint16_t(posiKey), hit);
+    return cluster(posiKey)->probe(uint16_t(posiKey), gen08, hit);
+}
+
+inline uint8_t TTable::generation() const noexcept {
+    return gen08;
+}
+inline void TTable::updateGeneration() noexcept {
+    gen08 += GENERATION_DELTA;
 }
 
 extern std::ostream& operator<<(std::ostream&, TTable const&);
 extern std::istream& operator>>(std::istream&, TTable&);
 
-// Global Transposition Table
-extern TTable TT;
+/// TBuffer keeps the entries a thread probes and writes between two sync points of the deterministic search.
+/// Meanwhile the table is read-only, the buffers are flushed to it at the sync point in thread order,
+/// so the content of the table doesn't depend on the scheduling of the threads.
+class TBuffer final {
+
+public:
+
+    void resize(size_t);
+    void clear() noexcept;
+
+    TEntry* probe(const Key, bool&) noexcept;
+
+private:
+
+    struct Slot {
+        Key    key;
+        TEntry entry;
+    };
+
+    std::vector<Slot>     slots;
+    std::vector<uint32_t> usedSlots; // Indices of the used slots, in order of use
+    TEntry                spare;     // Returned when the buffer is full, never flushed
+
+    friend class TTable;
+};
+
+// Transposition Table of the active engine
+extern TTable& TT() noexcept;
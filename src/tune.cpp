@@ -52,8 +52,8 @@ static void makeOption(const string &n, int v, const SetRange &r) {
         v = TuneResults[n];
     }
 
-    Options[n] << UCI::Option(v, r(v).first, r(v).second, on_tune);
-    LastOption = &Options[n];
+    Options()[n] << UCI::Option(v, r(v).first, r(v).second, on_tune);
+    LastOption = &Options()[n];
 
     // Print formatted parameters, ready to be copy-pasted in Fishtest
     std::cout
@@ -68,16 +68,16 @@ static void makeOption(const string &n, int v, const SetRange &r) {
 template<> void Tune::Entry<int>::initOption() noexcept { makeOption(name, value, range); }
 
 template<> void Tune::Entry<int>::readOption() noexcept {
-    if (Options.count(name)) {
-        value = int32_t(Options[name]);
+    if (Options().count(name)) {
+        value = int32_t(Options()[name]);
     }
 }
 
 template<> void Tune::Entry<Value>::initOption() noexcept { makeOption(name, value, range); }
 
 template<> void Tune::Entry<Value>::readOption() noexcept {
-    if (Options.count(name)) {
-        value = Value(int32_t(Options[name]));
+    if (Options().count(name)) {
+        value = Value(int32_t(Options()[name]));
     }
 }
 
@@ -87,11 +87,11 @@ template<> void Tune::Entry<Score>::initOption() noexcept {
 }
 
 template<> void Tune::Entry<Score>::readOption() noexcept {
-    if (Options.count("m" + name)) {
-        value = makeScore(int32_t(Options["m" + name]), egValue(value));
+    if (Options().count("m" + name)) {
+        value = makeScore(int32_t(Options()["m" + name]), egValue(value));
     }
-    if (Options.count("e" + name)) {
-        value = makeScore(mgValue(value), int32_t(Options["e" + name]));
+    if (Options().count("e" + name)) {
+        value = makeScore(mgValue(value), int32_t(Options()["e" + name]));
     }
 }
 
@@ -162,6 +162,8 @@ constexpr Depth DEPTH_OFFSET     { DEPTH_NONE - 1 }; // Used only for TT entry o
 
 // Maximum Depth
 constexpr int32_t MAX_PLY{ 256 + DEPTH_OFFSET - 4 };
+// Maximum Moves
+constexpr int32_t MAX_MOVES{ 256 };
 
 enum CastleSide {
     CS_KING, CS_QUEN, CS_CENTRE,
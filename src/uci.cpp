@@ -1,14 +1,20 @@
 #include "uci.h"
 
 #include <cassert>
+#include <cstdlib>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <iomanip>
+#include <map>
+#include <mutex>
 #include <optional>
 #include <sstream>
 #include <string>
 
 #include "polyglot.h"
 #include "position.h"
+#include "engine.h"
 #include "evaluator.h"
 #include "movegenerator.h"
 #include "notation.h"
@@ -23,6 +29,7 @@
 #include "helper/container.h"
 #include "helper/logger.h"
 #include "helper/reporter.h"
+#include "helper/memoryhandler.h"
 
 using namespace std;
 
@@ -33,8 +40,6 @@ string const Version{ "" };
 // Author Name
 string const Author{ "Ehsan Rashid" };
 
-UCI::OptionMap Options;
-
 std::optional<Logger> StdLogger;
 
 namespace {
@@ -154,6 +159,13 @@ string const compilerInfo() {
 #if defined(USE_NEON)
     oss << " NEON";
 #endif
+#if defined(USE_SLIDER_MAGIC)
+    oss << " SLIDER_MAGIC";
+#elif defined(USE_SLIDER_PEXT)
+    oss << " SLIDER_PEXT";
+#elif defined(USE_SLIDER_KOGGE)
+    oss << " SLIDER_KOGGE";
+#endif
 
 #if !defined(NDEBUG)
     oss << " DEBUG";
@@ -174,6 +186,13 @@ string const compilerInfo() {
 
 namespace UCI {
 
+    namespace {
+
+        // Values of the shared options, taken by the engines created later
+        std::mutex SharedMutex;
+        std::map<string, string, CaseInsensitiveLessComparer> SharedValues;
+    }
+
     Option::Option(OnChange onCng) noexcept :
         type{ "button" },
         onChange{ onCng } {
@@ -283,6 +302,16 @@ namespace UCI {
             }
         }
 
+        // A shared option sets a state of the whole process, that other engines may be using
+        std::unique_lock<std::mutex> uniqueLock(SharedMutex, std::defer_lock);
+        if (sharedVal != nullptr) {
+            uniqueLock.lock();
+            if (locked()) {
+                return *this;
+            }
+            *sharedVal = val;
+        }
+
         if (type != "button") {
             currentVal = val;
         }
@@ -304,6 +333,23 @@ namespace UCI {
         return defaultVal;
     }
 
+    /// Option::share() makes the option one setting of the whole process, kept in the given value:
+    /// the first engine sets the value, the engines created later take it.
+    void Option::share(string &value, bool first) noexcept {
+        if (first) {
+            value = currentVal;
+        } else {
+            currentVal = value;
+        }
+        sharedVal = &value;
+    }
+    /// Option::locked() checks if the option is shared by all the engines while several engines live,
+    /// so that it can not be changed.
+    bool Option::locked() const noexcept {
+        return sharedVal != nullptr
+            && Engine::count() > 1;
+    }
+
     /// Option::toString()
     string Option::toString() const noexcept {
         ostringstream oss;
@@ -352,7 +398,7 @@ namespace UCI {
     namespace {
 
         void onHash(Option const &o) noexcept {
-            TT.autoResize(o);
+            TT().autoResize(o);
         }
 
         void onClearHash(Option const&) noexcept {
@@ -360,22 +406,52 @@ namespace UCI {
         }
 
         void onSaveHash(Option const&) noexcept {
-            TT.save(Options["Hash File"]);
+            TT().save(Options()["Hash File"]);
         }
         void onLoadHash(Option const&) noexcept {
-            TT.load(Options["Hash File"]);
+            TT().load(Options()["Hash File"]);
         }
 
-        void onBookFile(Option const &o) noexcept {
-            Book.initialize(o);
+        void onBookFile(Option const&) noexcept {
+            Book().initialize(Options()["Book File"], Options()["Book Merge"] == "Sum");
         }
 
         void onThreads(Option const&) noexcept {
-            Threadpool.setup(optionThreads());
+            Threadpool().setup(optionThreads());
+        }
+
+#if defined(__linux__) && !defined(__ANDROID__)
+        void onThreadAffinity(Option const&) noexcept {
+            auto const &o{ Options()["Thread Affinity"] };
+            auto const &cpus{ Threadpool().cpus = Affinity::setup(
+                o == "Compact"  ? AFFINITY_COMPACT :
+                o == "Scatter"  ? AFFINITY_SCATTER :
+                o == "Physical" ? AFFINITY_PHYSICAL :
+                o == "List"     ? AFFINITY_LIST : AFFINITY_NONE,
+                Options()["Thread CPU List"]) };
+            if (!cpus.empty()) {
+                sync_cout << "info string Thread Affinity " << string_view(o) << ":";
+                for (auto const cpu : cpus) {
+                    std::cout << ' ' << cpu;
+                }
+                std::cout << sync_endl;
+            }
+            // Recreate the threads to place them
+            Threadpool().setup(optionThreads());
+        }
+#endif
+
+        void onDeterministic(Option const &o) noexcept {
+            Threadpool().deterministic = bool(o);
+        }
+
+        void onThreadSpin(Option const &o) noexcept {
+            // Spinning on a single processor only delays the thread that would wake it up
+            Threadpool().spinTime = std::thread::hardware_concurrency() > 1 ? uint32_t(o) : 0;
         }
 
         void onTimeNodes(Option const&) noexcept {
-            TimeMgr.clear();
+            TimeMgr().clear();
         }
 
         void onLogFile(Option const &o) noexcept {
@@ -385,9 +461,37 @@ namespace UCI {
             StdLogger.value().setup(o);
         }
 
+        // Tablebases of the process last set up, to set them up again only on a change
+        string  SyzygyPaths;
+        int16_t SyzygyWarmupLimit{ 0 };
+
         void onSyzygyPath(Option const &o) noexcept {
+            if (SyzygyPaths == string_view(o)) {
+                return;
+            }
+            SyzygyPaths = string_view(o);
             SyzygyTB::initialize(o);
+            SyzygyTB::warmup(Options()["SyzygyWarmup"]);
         }
+        void onSyzygyWarmup(Option const &o) noexcept {
+            if (SyzygyWarmupLimit == int16_t(o)) {
+                return;
+            }
+            SyzygyWarmupLimit = o;
+            SyzygyTB::warmup(o);
+        }
+        void onSyzygyBlockCache(Option const &o) noexcept {
+            SyzygyTB::resizeBlockCache(o);
+        }
+
+#if defined(USE_SLIDER_SELECT)
+        void onSliderAttacks(Option const &o) noexcept {
+            Bitboards::initializeSlider(
+                o == "Magic" ? SLIDER_MAGIC :
+                o == "PEXT"  ? SLIDER_PEXT :
+                o == "Kogge" ? SLIDER_KOGGE : Bitboards::autoSlider());
+        }
+#endif
 
         void onUseNNUE(Option const&) noexcept {
             Evaluator::NNUE::initialize();
@@ -399,66 +503,94 @@ namespace UCI {
 
     void initialize() noexcept {
 
-        Options["Hash"]               << Option(16, TTable::MinHashSize, TTable::MaxHashSize, onHash);
+        Options()["Hash"]               << Option(16, TTable::MinHashSize, TTable::MaxHashSize, onHash);
 
-        Options["Clear Hash"]         << Option(onClearHash);
-        Options["Retain Hash"]        << Option(false);
+        Options()["Clear Hash"]         << Option(onClearHash);
+        Options()["Retain Hash"]        << Option(false);
 
-        Options["Hash File"]          << Option(string("Hash.dat"));
-        Options["Save Hash"]          << Option(onSaveHash);
-        Options["Load Hash"]          << Option(onLoadHash);
+        Options()["Hash File"]          << Option(string("Hash.dat"));
+        Options()["Save Hash"]          << Option(onSaveHash);
+        Options()["Load Hash"]          << Option(onLoadHash);
 
-        Options["Use Book"]           << Option(false);
-        Options["Book File"]          << Option(string("Book.bin"), onBookFile);
-        Options["Book Pick Best"]     << Option(true);
-        Options["Book Move Num"]      << Option(20, 0, 100);
+        Options()["Use Book"]           << Option(false);
+        Options()["Book File"]          << Option(string("Book.bin"), onBookFile);
+        Options()["Book Merge"]         << Option(string("Sum var Sum var Override"), string("Sum"), onBookFile);
+        Options()["Book Pick Best"]     << Option(true);
+        Options()["Book Move Num"]      << Option(20, 0, 100);
 
-        Options["Threads"]            << Option(1, 0, 512, onThreads);
+        Options()["Threads"]            << Option(1, 0, 512, onThreads);
+#if defined(__linux__) && !defined(__ANDROID__)
+        Options()["Thread Affinity"]    << Option(string("None var None var Compact var Scatter var Physical var List"), string("None"),
+                                                  onThreadAffinity);
+        Options()["Thread CPU List"]    << Option(string(""), onThreadAffinity);
+#endif
+        Options()["Thread Spin"]        << Option(0, 0, 100000, onThreadSpin);
+        Options()["Deterministic"]      << Option(false, onDeterministic);
+
+        Options()["Skill Level"]        << Option(MaxLevel,  0, MaxLevel);
 
-        Options["Skill Level"]        << Option(MaxLevel,  0, MaxLevel);
+        Options()["MultiPV"]            << Option( 1, 1, 500);
+        Options()["Split MultiPV"]      << Option(false);
 
-        Options["MultiPV"]            << Option( 1, 1, 500);
+        Options()["Fixed Contempt"]     << Option( 24, -100, 100);
+        Options()["Contempt Time"]      << Option( 40,    0, 1000);
+        Options()["Contempt Value"]     << Option(100,    0, 1000);
+        Options()["Analysis Contempt"]  << Option(string("Both var Off var White var Black var Both"), string("Both"));
 
-        Options["Fixed Contempt"]     << Option( 24, -100, 100);
-        Options["Contempt Time"]      << Option( 40,    0, 1000);
-        Options["Contempt Value"]     << Option(100,    0, 1000);
-        Options["Analysis Contempt"]  << Option(string("Both var Off var White var Black var Both"), string("Both"));
+        Options()["Draw MoveCount"]     << Option(50, 5, 50);
 
-        Options["Draw MoveCount"]     << Option(50, 5, 50);
+        Options()["Overhead MoveTime"]  << Option( 10,  0, 5000);
+        Options()["Move Slowness"]      << Option(100, 10, 1000);
+        Options()["Ponder"]             << Option(true);
+        Options()["Time Nodes"]         << Option( 0,  0, 10000, onTimeNodes);
 
-        Options["Overhead MoveTime"]  << Option( 10,  0, 5000);
-        Options["Move Slowness"]      << Option(100, 10, 1000);
-        Options["Ponder"]             << Option(true);
-        Options["Time Nodes"]         << Option( 0,  0, 10000, onTimeNodes);
+        Options()["SyzygyPath"]         << Option(string(""), onSyzygyPath);
+        Options()["SyzygyDepthLimit"]   << Option(1, 1, 100);
+        Options()["SyzygyPieceLimit"]   << Option(SyzygyTB::TBPIECES, 0, SyzygyTB::TBPIECES);
+        Options()["SyzygyMove50Rule"]   << Option(true);
+        Options()["SyzygyWarmup"]       << Option(0, 0, SyzygyTB::TBPIECES, onSyzygyWarmup);
+        Options()["SyzygyBlockCache"]   << Option(0, 0, 4096, onSyzygyBlockCache);
 
-        Options["SyzygyPath"]         << Option(string(""), onSyzygyPath);
-        Options["SyzygyDepthLimit"]   << Option(1, 1, 100);
-        Options["SyzygyPieceLimit"]   << Option(SyzygyTB::TBPIECES, 0, SyzygyTB::TBPIECES);
-        Options["SyzygyMove50Rule"]   << Option(true);
+#if defined(USE_SLIDER_SELECT)
+        Options()["Slider Attacks"]     << Option(string("Auto var Auto var Magic var PEXT var Kogge"), string("Auto"),
+                                                  onSliderAttacks);
+#endif
 
-        Options["Use NNUE"]           << Option(true, onUseNNUE);
+        Options()["Use NNUE"]           << Option(true, onUseNNUE);
 
 #if defined(_MSC_VER)
-        Options["Eval File"]          << Option(string("src/") + DefaultEvalFile, onEvalFile);
+        Options()["Eval File"]          << Option(string("src/") + DefaultEvalFile, onEvalFile);
 #else
-        Options["Eval File"]          << Option(string("") + DefaultEvalFile, onEvalFile);
+        Options()["Eval File"]          << Option(string("") + DefaultEvalFile, onEvalFile);
 #endif
 
-        Options["Log File"]           << Option(string(""), onLogFile);
-
-        Options["UCI_Chess960"]       << Option(false);
-        Options["UCI_ShowWDL"]        << Option(false);
-        Options["UCI_AnalyseMode"]    << Option(false);
-        Options["UCI_LimitStrength"]  << Option(false);
-        Options["UCI_Elo"]            << Option(1350, 1350, 3100);
-
+        Options()["Log File"]           << Option(string(""), onLogFile);
+
+        Options()["UCI_Chess960"]       << Option(false);
+        Options()["UCI_ShowWDL"]        << Option(false);
+        Options()["UCI_AnalyseMode"]    << Option(false);
+        Options()["UCI_LimitStrength"]  << Option(false);
+        Options()["UCI_Elo"]            << Option(1350, 1350, 3100);
+
+        // Options of the state of the whole process: network, tablebases, sliding attacks and log
+        std::lock_guard<std::mutex> lockGuard(SharedMutex);
+        for (string const name : {
+                "Eval File",
+                "SyzygyPath", "SyzygyWarmup", "SyzygyBlockCache",
+#if defined(USE_SLIDER_SELECT)
+                "Slider Attacks",
+#endif
+                "Log File" }) {
+            auto const [itr, first]{ SharedValues.try_emplace(name) };
+            Options()[name].share(itr->second, first);
+        }
     }
 
-    namespace {
+    /// Forsyth-Edwards Notation (FEN) is a standard notation for describing a particular board position of a chess game.
+    /// The purpose of FEN is to provide all the necessary information to restart a game from a particular position.
+    string const StartFEN{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" };
 
-        /// Forsyth-Edwards Notation (FEN) is a standard notation for describing a particular board position of a chess game.
-        /// The purpose of FEN is to provide all the necessary information to restart a game from a particular position.
-        string const StartFEN{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" };
+    namespace {
 
         vector<string> const DefaultFens{
             // ---Chess Normal---
@@ -531,13 +663,111 @@ namespace UCI {
         void traceEval(Position &pos) {
             StateListPtr states{ new StateList{ 1 } };
             Position cPos;
-            cPos.setup(pos.fen(), states->back(), Threadpool.mainThread());
+            cPos.setup(pos.fen(), states->back(), Threadpool().mainThread());
 
-            Evaluator::NNUE::verify();
+            if (!Evaluator::NNUE::verify()) {
+                std::exit(EXIT_FAILURE);
+            }
 
             sync_cout << '\n' << Evaluator::trace(cPos) << sync_endl;
         }
 
+        /// movePick() is a micro-benchmark of the MovePicker, consistent with the histories gathered so far.
+        /// All the moves of the position are picked (valued & sorted) the given number of times.
+        void movePick(Position &pos, uint32_t count) {
+            auto const *th{ Threadpool().mainThread() };
+
+            PieceSquareStatsTable const *contStats[6];
+            std::fill(std::begin(contStats), std::end(contStats), &th->continuationStats[0][0][NO_PIECE][0]);
+            Move const killerMoves[2]{ MOVE_NONE, MOVE_NONE };
+
+            uint64_t moveCount{ 0 };
+            auto const start{ std::chrono::steady_clock::now() };
+            for (uint32_t i = 0; i < count; ++i) {
+                MovePicker movePicker{
+                    pos,
+                    MOVE_NONE, Depth(8),
+                    &th->mainStats,
+                    &th->lowPlyStats,
+                    &th->captureStats,
+                    contStats,
+                    1, killerMoves, MOVE_NONE };
+                while (movePicker.nextMove() != MOVE_NONE) {
+                    ++moveCount;
+                }
+            }
+            auto const elapsed{ std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count() };
+
+            count = std::max(count, 1U);
+            sync_cout << "Moves: " << moveCount / count
+                      << " ns/picker: " << elapsed / count
+                      << " ns/move: " << elapsed / std::max(moveCount, uint64_t(1)) << sync_endl;
+        }
+
+        /// printInfo() prints the information of a PV line according to UCI protocol.
+        void printInfo(SearchInfo const &info) {
+            ostringstream oss;
+            if (info.depth == DEPTH_ZERO) {
+                oss << "info"
+                    << " depth " << 0
+                    << " score " << info.value
+                    << " time "  << 0;
+            } else {
+                oss << std::setfill('0')
+                    << "info"
+                    << " depth "    << std::setw(2) << info.depth
+                    << " seldepth " << std::setw(2) << info.selDepth
+                    << " multipv "  << info.multiPV
+                    << std::setfill(' ')
+                    << " score "    << info.value;
+                if (Options()["UCI_ShowWDL"]) {
+                oss << " wdl " << info.wdl[0] << " " << info.wdl[1] << " " << info.wdl[2];
+                }
+                oss << (info.bound == BOUND_LOWER ? " lowerbound" :
+                        info.bound == BOUND_UPPER ? " upperbound" : "")
+                    << " nodes "    << info.nodes
+                    << " time "     << info.time
+                    << " nps "      << info.nodes * 1000 / info.time
+                    << " tbhits "   << info.tbHits;
+                if (info.hashFull >= 0) {
+                oss << " hashfull " << info.hashFull;
+                }
+                oss << " pv ";
+                for (auto const m : info.pv) {
+                oss << m << " ";
+                }
+            }
+            sync_cout << oss.str() << sync_endl;
+        }
+
+        void printCurrMove(CurrMoveInfo const &info) {
+            sync_cout << std::setfill('0')
+                      << "info"
+                      << " depth "          << std::setw(2) << info.depth
+                      << " seldepth "       << std::setw(2) << info.selDepth
+                      << " currmove "       << info.move
+                      << " currmovenumber " << std::setw(2) << info.moveNumber
+                      << " time "           << info.time
+                      << std::setfill(' ')  << sync_endl;
+        }
+
+        /// printMessage() prints each line of the message as an info string.
+        void printMessage(string_view msg) {
+            istringstream iss{ string{ msg } };
+            string line;
+            while (std::getline(iss, line, '\n')) {
+                sync_cout << "info string " << line << sync_endl;
+            }
+        }
+
+        void printBestMove(Move bm, Move pm) {
+            sync_cout << "bestmove " << bm;
+            if (pm != MOVE_NONE) {
+                std::cout << " ponder " << pm;
+            }
+            std::cout << sync_endl;
+        }
+
         /// setoption() updates the UCI option ("name") to the given value ("value").
         void setOption(istringstream &iss, Position &pos) {
             string token;
@@ -558,11 +788,15 @@ namespace UCI {
                 value += (value.empty() ? "" : " ") + token;
             }
 
-            if (contains(Options, name)) {
-                Options[name] = value;
+            if (contains(Options(), name)) {
+                if (Options()[name].locked()) {
+                    sync_cout << "info string option " << name << " is shared by the engines, unchangeable while several run" << sync_endl;
+                    return;
+                }
+                Options()[name] = value;
                 sync_cout << "info string option " << name << " = " << value << sync_endl;
-                if (pos.thread() != Threadpool.mainThread()) {
-                    pos.thread(Threadpool.mainThread());
+                if (pos.thread() != Threadpool().mainThread()) {
+                    pos.thread(Threadpool().mainThread());
                 }
             } else {
                 sync_cout << "No such option: \'" << name << "\'" << sync_endl;
@@ -571,6 +805,7 @@ namespace UCI {
 
         /// position() sets up the starting position ("startpos")/("fen <fenstring>") and then
         /// makes the moves given in the move list ("moves") also saving the moves on stack.
+        /// GUIs resend the whole game every move, so the moves of the last setup are not replayed.
         void position(istringstream &iss, Position &pos, StateListPtr &states) {
             string token;
             iss >> token; // Consume "startpos" or "fen" token
@@ -590,45 +825,74 @@ namespace UCI {
                 return;
             }
 
-            // Drop old and create a new one
-            states = StateListPtr{ new StateList{ 1 } };
-            pos.setup(fen, states->back(), Threadpool.mainThread());
-            //assert(pos.fen() == toString(trim(fen)));
+            vector<string> moves;
+            while (iss >> token) {
+                moves.push_back(token);
+            }
+
+            auto &lastSetup{ ActiveEngine->lastSetup };
+            bool const chess960{ Options()["UCI_Chess960"] };
+            bool extended{ false };
+            if (fen == lastSetup.fen
+             && chess960 == lastSetup.chess960
+             && moves.size() >= lastSetup.moves.size()
+             && std::equal(lastSetup.moves.begin(), lastSetup.moves.end(), moves.begin())) {
+                // The states went to the last search, take them back if it is finished
+                if (states.get() == nullptr) {
+                    states = Threadpool().releaseStates();
+                }
+                if (states.get() != nullptr) {
+                    assert(states->size() == lastSetup.moves.size() + 1);
+                    assert(pos.state() == &states->back());
+                    extended = true;
+                }
+            }
+
+            if (!extended) {
+                // Drop old and create a new one
+                states = StateListPtr{ new StateList{ 1 } };
+                pos.setup(fen, states->back(), Threadpool().mainThread());
+                //assert(pos.fen() == toString(trim(fen)));
+                lastSetup.fen = fen;
+                lastSetup.moves.clear();
+                lastSetup.chess960 = chess960;
+            }
 
             // Parse and validate moves (if any)
-            while (iss >> token) {
-                auto const m{ moveOfCAN(token, pos) };
+            for (auto itr = moves.begin() + lastSetup.moves.size(); itr != moves.end(); ++itr) {
+                auto const m{ moveOfCAN(*itr, pos) };
                 if (m == MOVE_NONE) {
-                    std::cerr << "ERROR: Illegal Move '" << token << "' at " << iss.tellg() << '\n';
+                    std::cerr << "ERROR: Illegal Move '" << *itr << "' at " << itr - moves.begin() + 1 << '\n';
                     break;
                 }
 
                 states->emplace_back();
                 pos.doMove(m, states->back());
+                lastSetup.moves.push_back(*itr);
             }
         }
 
         /// go() sets the thinking time and other parameters from the input string, then starts the search.
         void go(istringstream &iss, Position &pos, StateListPtr &states) {
-            Threadpool.stopThinking();
-            Threadpool.ponder = false;
+            Threadpool().stopThinking();
+            Threadpool().ponder = false;
 
-            TimeMgr.startTime = now(); // As early as possible!
-            Limits.clear();
+            TimeMgr().startTime = now(); // As early as possible!
+            Limits().clear();
 
             string token;
             while (iss >> token) {
-                if (token == "wtime")     { iss >> Limits.clock[WHITE].time; } else
-                if (token == "btime")     { iss >> Limits.clock[BLACK].time; } else
-                if (token == "winc")      { iss >> Limits.clock[WHITE].inc; } else
-                if (token == "binc")      { iss >> Limits.clock[BLACK].inc; } else
-                if (token == "movestogo") { iss >> Limits.movestogo; } else
-                if (token == "movetime")  { iss >> Limits.moveTime; } else
-                if (token == "depth")     { iss >> Limits.depth; } else
-                if (token == "nodes")     { iss >> Limits.nodes; } else
-                if (token == "mate")      { iss >> Limits.mate; } else
-                if (token == "infinite")  { Limits.infinite = true; } else
-                if (token == "ponder")    { Threadpool.ponder = true; } else
+                if (token == "wtime")     { iss >> Limits().clock[WHITE].time; } else
+                if (token == "btime")     { iss >> Limits().clock[BLACK].time; } else
+                if (token == "winc")      { iss >> Limits().clock[WHITE].inc; } else
+                if (token == "binc")      { iss >> Limits().clock[BLACK].inc; } else
+                if (token == "movestogo") { iss >> Limits().movestogo; } else
+                if (token == "movetime")  { iss >> Limits().moveTime; } else
+                if (token == "depth")     { iss >> Limits().depth; } else
+                if (token == "nodes")     { iss >> Limits().nodes; } else
+                if (token == "mate")      { iss >> Limits().mate; } else
+                if (token == "infinite")  { Limits().infinite = true; } else
+                if (token == "ponder")    { Threadpool().ponder = true; } else
                 // Needs to be the last command on the line
                 if (token == "searchmoves") {
                     // Parse and Validate search-moves (if any)
@@ -638,13 +902,13 @@ namespace UCI {
                             std::cerr << "ERROR: Illegal Rootmove '" << token << "'\n";
                             continue;
                         }
-                        Limits.searchMoves += m;
+                        Limits().searchMoves += m;
                     }
                 } else
                 if (token == "ignoremoves") {
                     // Parse and Validate ignore-moves (if any)
                     for (auto const &vm : MoveList<LEGAL>(pos)) {
-                        Limits.searchMoves += vm;
+                        Limits().searchMoves += vm;
                     }
                     while (iss >> token) {
                         auto const m{ moveOfCAN(token, pos) };
@@ -652,15 +916,19 @@ namespace UCI {
                             std::cerr << "ERROR: Illegal Rootmove '" << token << "'\n";
                             continue;
                         }
-                        if (Limits.searchMoves.contains(m)) {
-                            Limits.searchMoves -= m;
+                        if (Limits().searchMoves.contains(m)) {
+                            Limits().searchMoves -= m;
                         }
                     }
                 } else {
                     //std::cerr << "Unknown token : " << token << '\n';
                 }
             }
-            Threadpool.startThinking(pos, states);
+            // No search without the network
+            if (!Evaluator::NNUE::verify()) {
+                std::exit(EXIT_FAILURE);
+            }
+            Threadpool().startThinking(pos, states);
         }
 
         /// setupBench() builds a list of UCI commands to be run by bench.
@@ -674,6 +942,7 @@ namespace UCI {
         ///     * nodes
         ///     * mate
         ///     * perft
+        ///     * movepick
         /// - FEN positions to be used in FEN format
         ///     * 'default' for builtin positions (default)
         ///     * 'current' for current position
@@ -689,6 +958,7 @@ namespace UCI {
         /// bench 64 4 5000 movetime current -> search current position with 4 threads for 5 sec (TT = 64MB)
         /// bench 64 1 100000 nodes -> search default positions for 100K nodes (TT = 64MB)
         /// bench 16 1 5 perft -> run perft 5 on default positions
+        /// bench 16 1 100000 movepick -> pick all moves 100K times on default positions
         vector<string> setupBench(istringstream &iss, Position const &pos) {
             string token;
             // Assign default values to missing arguments
@@ -701,7 +971,8 @@ namespace UCI {
 
             string command{
                 limit == "eval"  ? limit :
-                limit == "perft" ? limit + " " + value :
+                limit == "perft"
+             || limit == "movepick" ? limit + " " + value :
                                    "go " + limit + " " + value };
 
             vector<string> fens;
@@ -725,7 +996,7 @@ namespace UCI {
                 }
             }
 
-            bool uciChess960{ Options["UCI_Chess960"] };
+            bool uciChess960{ Options()["UCI_Chess960"] };
 
             vector<string> uciCmds;
             uciCmds.emplace_back("setoption name Threads value " + threads);
@@ -759,26 +1030,34 @@ namespace UCI {
                 uciCmds.emplace_back("setoption name UCI_Chess960 value " + toString(uciChess960));
                 uciCmds.emplace_back("position fen " + pos.fen());
             }
-            uciCmds.emplace_back("setoption name Use NNUE value " + Options["Use NNUE"].defaultValue());
+            uciCmds.emplace_back("setoption name Use NNUE value " + Options()["Use NNUE"].defaultValue());
 
             return uciCmds;
         }
 
         /// bench() setup list of UCI commands is setup according to bench parameters,
-        /// then it is run one by one printing a summary at the end.
-        void bench(istringstream &isstream, Position &pos, StateListPtr &states) {
+        /// then it is run one by one printing a summary at the end. Returns the nodes/second.
+        uint64_t bench(istringstream &isstream, Position &pos, StateListPtr &states) {
 
             auto const uciCmds{ setupBench(isstream, pos) };
             auto const cmdCount{ std::count_if(uciCmds.begin(), uciCmds.end(),
                                             [](string const &s) {
                                                 return s.find("eval") == 0
                                                     || s.find("perft ") == 0
+                                                    || s.find("movepick ") == 0
                                                     || s.find("go ") == 0;
                                             }) };
 
             Reporter::reset();
+            Threadpool().stopLatency.clear();
+            Threadpool().deadlineLatency.clear();
+            Threadpool().searchStats.clear();
+            Threadpool().tbStats.clear();
             TimePoint elapsed{ now() };
             uint64_t nodes{ 0 };
+            uint64_t avgLatency{ 0 };
+            uint64_t maxLatency{ 0 };
+            int32_t goCount{ 0 };
             int32_t i{ 0 };
             for (auto const &cmd : uciCmds) {
                 istringstream iss{ cmd };
@@ -787,6 +1066,7 @@ namespace UCI {
 
                 if (token == "eval"
                  || token == "perft"
+                 || token == "movepick"
                  || token == "go") {
 
                     std::cerr << "\n---------------\nPosition: "
@@ -801,10 +1081,21 @@ namespace UCI {
 
                         perft<true>(pos, depth);
                     } else
+                    if (token == "movepick") {
+                        uint32_t count{ 1 };
+                        iss >> count;
+
+                        movePick(pos, count);
+                    } else
                     if (token == "go") {
                         go(iss, pos, states);
-                        Threadpool.mainThread()->waitIdle();
-                        nodes += Threadpool.accumulate(&Thread::nodes);
+                        Threadpool().mainThread()->waitIdle();
+                        nodes += Threadpool().accumulate(&Thread::nodes);
+
+                        uint64_t latency;
+                        avgLatency += Threadpool().wakeUpLatency(latency);
+                        maxLatency = std::max(latency, maxLatency);
+                        ++goCount;
                     }
                 } else
                 if (token == "setoption") {
@@ -830,10 +1121,345 @@ namespace UCI {
                 << "\n=================================\n"
                 << "Total time (ms) :" << std::setw(16) << elapsed << '\n'
                 << "Nodes searched  :" << std::setw(16) << nodes << '\n'
-                << "Nodes/second    :" << std::setw(16) << nodes * 1000 / elapsed
-                << "\n---------------------------------\n";
+                << "Nodes/second    :" << std::setw(16) << nodes * 1000 / elapsed << '\n';
+            if (goCount != 0) {
+                // Latency from 'go' to the threads starting the search
+                oss << "Wake-up avg (us):" << std::setw(16) << avgLatency / goCount << '\n'
+                    << "Wake-up max (us):" << std::setw(16) << maxLatency << '\n'
+                    << "Stop latency    : " << Threadpool().stopLatency.toString() << '\n'
+                    << "Deadline latency: " << Threadpool().deadlineLatency.toString() << '\n';
+            }
+#if defined(USE_STATS)
+            oss << "---------------------------------\n"
+                << Threadpool().searchStats.toString()
+                << Threadpool().tbStats.toString();
+#endif
+            oss << "---------------------------------\n";
+            std::cerr << oss.str() << '\n';
+            return nodes * 1000 / elapsed;
+        }
+
+#if defined(__linux__) && !defined(__ANDROID__)
+        /// benchAffinity() runs bench with each thread affinity policy, doubling the threads
+        /// up to the given count, then prints the nodes/second scaling curve of each policy.
+        /// There are five parameters, as bench:
+        /// - TT size in MB (default is 16)
+        /// - max Threads count (default is the processors count)
+        /// - limit value (default is 13)
+        /// - limit type (default is depth)
+        /// - FEN positions (default is default)
+        /// example:
+        /// benchaffinity 256 16 5000 movetime current -> search current position for 5 sec with 1, 2, 4, 8, 16 threads
+        void benchAffinity(istringstream &isstream, Position &pos, StateListPtr &states) {
+            string token;
+            string    hash{ (isstream >> token) && !whiteSpaces(token) ? token : "16" };
+            string threads{ (isstream >> token) && !whiteSpaces(token) ? token : std::to_string(std::thread::hardware_concurrency()) };
+            string   value{ (isstream >> token) && !whiteSpaces(token) ? token : "13" };
+            string   limit{ (isstream >> token) && !whiteSpaces(token) ? token : "depth" };
+            string fenFile{ (isstream >> token) && !whiteSpaces(token) ? token : "default" };
+
+            uint16_t threadCount{ 1 };
+            istringstream{ threads } >> threadCount;
+            threadCount = std::max(threadCount, uint16_t(1));
+
+            vector<uint16_t> threadCounts;
+            for (uint16_t t = 1; t < threadCount; t *= 2) {
+                threadCounts.push_back(t);
+            }
+            threadCounts.push_back(threadCount);
+
+            string const affinity{ string_view(Options()["Thread Affinity"]) };
+
+            ostringstream oss;
+            oss << "\nThread Affinity scaling (nodes/second, speedup over 1 thread)\n"
+                << std::left << std::setw(9) << "Threads";
+            for (auto const t : threadCounts) {
+                oss << std::right << std::setw(17) << t;
+            }
+            oss << '\n';
+            for (string_view const policy : { "None", "Compact", "Scatter", "Physical" }) {
+                Options()["Thread Affinity"] = policy;
+
+                oss << std::left << std::setw(9) << policy;
+                uint64_t nps1{ 0 };
+                for (auto const t : threadCounts) {
+                    istringstream iss{ hash + " " + std::to_string(t) + " " + value + " " + limit + " " + fenFile };
+                    auto const nps{ bench(iss, pos, states) };
+                    if (nps1 == 0) {
+                        nps1 = std::max(nps, uint64_t(1));
+                    }
+                    oss << std::right << std::setw(10) << nps
+                        << " (" << std::fixed << std::setprecision(2) << std::setw(4) << double(nps) / nps1 << ")";
+                }
+                oss << '\n';
+            }
+            Options()["Thread Affinity"] = affinity;
+
             std::cerr << oss.str() << '\n';
         }
+#endif
+
+        /// readPositions() reads the positions of an EPD/FEN file, one per line.
+        /// An EPD line has only the first four FEN fields followed by the operations.
+        /// The default positions skip the Chess960 ones, all positions are searched with the same options.
+        vector<string> readPositions(string const &fenFile) {
+            vector<string> lines;
+            if (fenFile == "default") {
+                bool chess960{ false };
+                for (auto const &fen : DefaultFens) {
+                    if (fen.find("setoption") != string::npos) {
+                        if (fen.find("UCI_Chess960") != string::npos) {
+                            chess960 = fen.find("true") != string::npos;
+                        }
+                    } else
+                    if (!chess960) {
+                        lines.push_back(fen);
+                    }
+                }
+            } else {
+                std::ifstream ifstream{ fenFile, std::ios::in };
+                if (!ifstream.is_open()) {
+                    std::cerr << "ERROR: unable to open file ... \'" << fenFile << "\'\n";
+                }
+                string line;
+                while (std::getline(ifstream, line, '\n')) {
+                    lines.push_back(line);
+                }
+                ifstream.close();
+            }
+
+            vector<string> fens;
+            for (auto const &line : lines) {
+                istringstream iss{ line };
+                string fen, token;
+                for (uint8_t f = 0; f < 4 && iss >> token; ++f) {
+                    fen += token + " ";
+                }
+                if (whiteSpaces(fen)) {
+                    continue;
+                }
+                // Move clocks are optional in EPD
+                string clock, move;
+                auto const digit{ [](char c) { return std::isdigit(uint8_t(c)) != 0; } };
+                if (iss >> clock >> move
+                 && std::all_of(clock.begin(), clock.end(), digit)
+                 && std::all_of(move.begin(), move.end(), digit)) {
+                    fen += clock + " " + move;
+                } else {
+                    fen += "0 1";
+                }
+                fens.push_back(fen);
+            }
+            return fens;
+        }
+
+        /// batch() analyses the positions of an EPD/FEN file with independent searches.
+        /// Each worker thread drives its own single-threaded engine with a private hash,
+        /// takes the next position and prints the result as soon as it is ready.
+        /// With "compare" the positions are searched again one at a time by this engine using
+        /// as many threads as the workers, to compare the positions per hour of both approaches.
+        /// Like bench, the comparison clears the hash and the histories of this engine (as "ucinewgame"),
+        /// then it sets up the start position.
+        /// There are six parameters:
+        /// - EPD/FEN file ("default" for the bench positions)
+        /// - Workers count (default is the processors count)
+        /// - limit value (default is 10)
+        /// - limit type: depth (default), nodes or movetime
+        /// - TT size in MB per worker (default is 16)
+        /// - "compare" (optional)
+        void batch(istringstream &isstream, Position &pos, StateListPtr &states) {
+            string token;
+            string fenFile{ (isstream >> token) && !whiteSpaces(token) ? token : "default" };
+            string workers{ (isstream >> token) && !whiteSpaces(token) ? token : std::to_string(std::thread::hardware_concurrency()) };
+            string   value{ (isstream >> token) && !whiteSpaces(token) ? token : "10" };
+            string   limit{ (isstream >> token) && !whiteSpaces(token) ? toLower(token) : "depth" };
+            string    hash{ (isstream >> token) && !whiteSpaces(token) ? token : "16" };
+            bool const compare{ (isstream >> token) && toLower(token) == "compare" };
+
+            auto const fens{ readPositions(fenFile) };
+            if (fens.empty()) {
+                return;
+            }
+
+            uint16_t workerCount{ 1 };
+            istringstream{ workers } >> workerCount;
+            workerCount = std::clamp(workerCount, uint16_t(1), uint16_t(fens.size()));
+
+            string const goCmd{ limit + " " + value };
+
+            // Options the workers take from this engine
+            vector<std::pair<string, string>> options;
+            for (string const name : {
+                    "Use NNUE", "Eval File",
+                    "Fixed Contempt", "Contempt Time", "Contempt Value", "Analysis Contempt",
+                    "Draw MoveCount",
+                    "SyzygyDepthLimit", "SyzygyPieceLimit", "SyzygyMove50Rule",
+                    "UCI_Chess960", "UCI_AnalyseMode" }) {
+                options.emplace_back(name, string(string_view(Options()[name])));
+            }
+
+            // Placement the workers take from this engine
+            auto const &cpus{ Threadpool().cpus };
+
+            std::atomic<size_t> nextIdx{ 0 };
+            std::atomic<uint64_t> totalNodes{ 0 };
+
+            TimePoint elapsed{ now() };
+
+            vector<std::thread> threads;
+            for (uint16_t w = 0; w < workerCount; ++w) {
+                threads.emplace_back(
+                    [&, w]() {
+                        Engine engine;
+                        EngineScope engineScope{ &engine };
+
+                        for (auto const &[name, val] : options) {
+                            if (string_view(Options()[name]) != val) {
+                                Options()[name] = val;
+                            }
+                        }
+                        Options()["Hash"] = hash;
+                        // Place the thread of each worker on its own processor
+                        Threadpool().cpus = cpus;
+                        Threadpool().bindOffset = w;
+                        Threadpool().setup(1);
+
+                        SearchInfo info{};
+                        Move bestMove{ MOVE_NONE };
+                        engine.onInfo     = [&](SearchInfo const &si) { if (si.multiPV <= 1) info = si; };
+                        engine.onBestMove = [&](Move bm, Move) { bestMove = bm; };
+
+                        Position wPos;
+                        StateListPtr wStates;
+                        size_t idx;
+                        while ((idx = nextIdx.fetch_add(1)) < fens.size()) {
+                            wStates.reset(new StateList{ 1 });
+                            wPos.setup(fens[idx], wStates->back(), Threadpool().mainThread());
+
+                            istringstream iss{ goCmd };
+                            go(iss, wPos, wStates);
+                            Threadpool().mainThread()->waitIdle();
+
+                            auto const nodes{ Threadpool().accumulate(&Thread::nodes) };
+                            totalNodes += nodes;
+
+                            sync_cout << "batch " << idx + 1
+                                      << " bestmove " << bestMove
+                                      << " score "    << info.value
+                                      << " depth "    << info.depth
+                                      << " seldepth " << info.selDepth
+                                      << " nodes "    << nodes
+                                      << " time "     << info.time
+                                      << " fen "      << fens[idx] << sync_endl;
+                        }
+                    });
+            }
+            for (auto &th : threads) {
+                th.join();
+            }
+
+            elapsed = std::max(now() - elapsed, { 1 });
+
+            ostringstream oss;
+            oss << std::right
+                << "\n=================================\n"
+                << "Positions       :" << std::setw(16) << fens.size() << '\n'
+                << "Workers         :" << std::setw(16) << workerCount << '\n'
+                << "Total time (ms) :" << std::setw(16) << elapsed << '\n'
+                << "Nodes searched  :" << std::setw(16) << totalNodes << '\n'
+                << "Nodes/second    :" << std::setw(16) << totalNodes * 1000 / elapsed << '\n'
+                << "Positions/hour  :" << std::setw(16) << fens.size() * 3600000 / elapsed << '\n';
+
+            if (compare) {
+                // Same positions, one search at a time with all the threads
+                auto const threadCount{ string(string_view(Options()["Threads"])) };
+                auto const hashSize{ string(string_view(Options()["Hash"])) };
+                auto const onInfo{ ActiveEngine->onInfo };
+                auto const onCurrMove{ ActiveEngine->onCurrMove };
+                auto const onBestMove{ ActiveEngine->onBestMove };
+                auto const onMessage{ ActiveEngine->onMessage };
+                ActiveEngine->onInfo     = nullptr;
+                ActiveEngine->onCurrMove = nullptr;
+                ActiveEngine->onBestMove = nullptr;
+                ActiveEngine->onMessage  = nullptr;
+                Options()["Threads"] = std::to_string(workerCount);
+                Options()["Hash"] = hash;
+                UCI::clear();
+
+                TimePoint cElapsed{ now() };
+                uint64_t cNodes{ 0 };
+                ActiveEngine->lastSetup.clear();
+                for (auto const &fen : fens) {
+                    states.reset(new StateList{ 1 });
+                    pos.setup(fen, states->back(), Threadpool().mainThread());
+
+                    istringstream iss{ goCmd };
+                    go(iss, pos, states);
+                    Threadpool().mainThread()->waitIdle();
+                    cNodes += Threadpool().accumulate(&Thread::nodes);
+                }
+                cElapsed = std::max(now() - cElapsed, { 1 });
+
+                Options()["Threads"] = threadCount;
+                Options()["Hash"] = hashSize;
+                ActiveEngine->onInfo     = onInfo;
+                ActiveEngine->onCurrMove = onCurrMove;
+                ActiveEngine->onBestMove = onBestMove;
+                ActiveEngine->onMessage  = onMessage;
+
+                oss << "---------------------------------\n"
+                    << "Single search with " << workerCount << " threads\n"
+                    << "Total time (ms) :" << std::setw(16) << cElapsed << '\n'
+                    << "Nodes searched  :" << std::setw(16) << cNodes << '\n'
+                    << "Nodes/second    :" << std::setw(16) << cNodes * 1000 / cElapsed << '\n'
+                    << "Positions/hour  :" << std::setw(16) << fens.size() * 3600000 / cElapsed << '\n';
+
+                // Restore a valid position on the current threads
+                states.reset(new StateList{ 1 });
+                pos.setup(StartFEN, states->back(), Threadpool().mainThread());
+            }
+            oss << "---------------------------------\n";
+            std::cerr << oss.str() << '\n';
+        }
+
+        /// makeBook() builds a Polyglot book from PGN games.
+        /// There are six parameters:
+        /// - PGN files, separated by ';'
+        /// - Book file (default is book.bin)
+        /// - Workers count (default is the threads count)
+        /// - Max ply of the moves (default is 60)
+        /// - Min games of a move (default is 1)
+        /// - Memory in MB before spilling to the run files (default is 256)
+        void makeBook(istringstream &isstream) {
+            string token;
+            string pgnFiles{ (isstream >> token) && !whiteSpaces(token) ? token : "" };
+            string bookFile{ (isstream >> token) && !whiteSpaces(token) ? token : "book.bin" };
+            string  workers{ (isstream >> token) && !whiteSpaces(token) ? token : std::to_string(Threadpool().size()) };
+            string   maxPly{ (isstream >> token) && !whiteSpaces(token) ? token : "60" };
+            string minGames{ (isstream >> token) && !whiteSpaces(token) ? token : "1" };
+            string   memory{ (isstream >> token) && !whiteSpaces(token) ? token : "256" };
+
+            if (whiteSpaces(pgnFiles)) {
+                sync_cout << "info string No PGN file" << sync_endl;
+                return;
+            }
+
+            uint16_t workerCount{ 1 };
+            istringstream{ workers } >> workerCount;
+            workerCount = std::max(workerCount, uint16_t(1));
+            int16_t plies{ 60 };
+            istringstream{ maxPly } >> plies;
+            uint32_t games{ 1 };
+            istringstream{ minGames } >> games;
+            uint32_t memoryMB{ 256 };
+            istringstream{ memory } >> memoryMB;
+
+            // Workers position the search threads, so the search must be idle
+            Threadpool().mainThread()->waitIdle();
+            if (!::makeBook(split(pgnFiles, ';'), bookFile, workerCount, plies, std::max(games, uint32_t(1)), std::max(memoryMB, uint32_t(1)))) {
+                sync_cout << "info string Book not made: " << bookFile << sync_endl;
+            }
+        }
     }
 
     /// handleCommands() waits for a command from stdin, parses it and calls the appropriate function.
@@ -841,13 +1467,18 @@ namespace UCI {
     /// Single command line arguments is executed once and returns immediately, e.g. 'bench'.
     /// In addition to the UCI ones, also some additional commands are supported.
     void handleCommands(int argc, char const *const argv[]) {
+        // The search output is printed as UCI text
+        ActiveEngine->onInfo     = printInfo;
+        ActiveEngine->onCurrMove = printCurrMove;
+        ActiveEngine->onBestMove = printBestMove;
+        ActiveEngine->onMessage  = printMessage;
 
         Position pos;
         // Stack to keep track of the position states along the setup moves
         // (from the start position to the position just before the search starts).
         // Needed by 'draw by repetition' detection.
         StateListPtr states{ new StateList{ 1 } };
-        pos.setup(StartFEN, states->back(), Threadpool.mainThread());
+        pos.setup(StartFEN, states->back(), Threadpool().mainThread());
 
         // Join arguments
         string cmd;
@@ -871,13 +1502,13 @@ namespace UCI {
 
             if (token == "quit"
              || token == "stop") {
-                Threadpool.stop = true;
+                Threadpool().raiseStop();
             } else
             // GUI sends 'ponderhit' to tell that the opponent has played the expected move.
             // So 'ponderhit' will be sent if told to ponder on the same move the opponent has played.
             // Now should continue searching but switch from pondering to normal search.
             if (token == "ponderhit") {
-                Threadpool.ponder = false; // Switch to normal search
+                Threadpool().ponder = false; // Switch to normal search
             } else
             if (token == "isready") {
                 sync_cout << "readyok" << sync_endl;
@@ -885,7 +1516,7 @@ namespace UCI {
             if (token == "uci") {
                 sync_cout << "id name "     << Name << " " << engineInfo() << '\n'
                           << "id author "   << Author << '\n'
-                          << Options
+                          << Options()
                           << "uciok" << sync_endl;
             } else
             if (token == "ucinewgame") {
@@ -905,11 +1536,54 @@ namespace UCI {
             if (token == "bench") {
                 bench(iss, pos, states);
             } else
+#if defined(__linux__) && !defined(__ANDROID__)
+            if (token == "benchaffinity") {
+                benchAffinity(iss, pos, states);
+            } else
+#endif
+            if (token == "batch") {
+                batch(iss, pos, states);
+            } else
+            if (token == "makebook") {
+                makeBook(iss);
+            } else
             if (token == "flip") {
                 pos.flip();
+                ActiveEngine->lastSetup.clear();
             } else
             if (token == "mirror") {
                 pos.mirror();
+                ActiveEngine->lastSetup.clear();
+            } else
+            if (token == "stoplatency") {
+                sync_cout << "info string Stop latency "     << Threadpool().stopLatency.toString() << '\n'
+                          << "info string Deadline latency " << Threadpool().deadlineLatency.toString() << sync_endl;
+            } else
+            if (token == "tbcache") {
+                // Tablebase probes of the last search answered by the cache of the threads,
+                // the time saved is estimated from the time of the probes missing it.
+                // The block cache is shared by the engines, its lookups add up until 'tbcache reset'
+                iss >> token;
+                if (token == "reset") {
+                    SyzygyTB::resetBlockCacheCounts();
+                } else {
+                    auto const hits{ Threadpool().accumulate(&Thread::tbCacheHits) };
+                    auto const misses{ Threadpool().accumulate(&Thread::tbCacheMisses) };
+                    auto const probeTime{ Threadpool().accumulate(&Thread::tbProbeTime) };
+                    sync_cout << "info string Tablebase cache hits " << hits << " of " << hits + misses << " probes"
+                              << " (" << (hits + misses != 0 ? 100 * hits / (hits + misses) : 0) << "%)"
+                              << " saved ~" << (misses != 0 ? hits * (probeTime / misses) / 1000 : 0) << " us" << '\n'
+                              << "info string Tablebase block cache (cumulative) " << SyzygyTB::blockCacheInfo() << sync_endl;
+                }
+            } else
+            if (token == "report") {
+                // Dump the run-time statistics merged from all threads, 'report reset' clears them
+                iss >> token;
+                if (token == "reset") {
+                    Reporter::reset();
+                } else {
+                    printMessage(Reporter::toString());
+                }
             } else
             if (token == "compiler") {
                 sync_cout << compilerInfo() << sync_endl;
@@ -928,6 +1602,41 @@ namespace UCI {
 
                 perft<true>(pos, depth, detail);
             } else
+            if (token == "movepick") {
+                uint32_t count{ 1 };
+                iss >> count;
+
+                movePick(pos, count);
+            } else
+            if (token == "bookprobe") {
+                uint32_t count{ 1000000 };
+                iss >> count;
+
+                sync_cout;
+                Book().benchProbe(count);
+                std::cout << sync_endl;
+            } else
+            if (token == "tbprobe") {
+                uint16_t threads{ 64 };
+                uint32_t count{ 10000 };
+                iss >> threads >> count;
+
+                // Reload the tables, so the probes map them concurrently
+                Threadpool().mainThread()->waitIdle();
+                SyzygyTB::initialize(Options()["SyzygyPath"]);
+                sync_cout;
+                SyzygyTB::benchProbe(threads, count);
+                std::cout << sync_endl;
+                SyzygyTB::warmup(Options()["SyzygyWarmup"]);
+            } else
+            if (token == "sliders") {
+                uint32_t count{ 100000 };
+                iss >> count;
+
+                sync_cout;
+                Bitboards::benchSlider(count);
+                std::cout << sync_endl;
+            } else
             if (token == "keys") {
                 ostringstream oss;
                 oss << "FEN: " << pos.fen() << '\n'
@@ -1010,19 +1719,23 @@ namespace UCI {
 
     /// clear() clear all stuff
     void clear() noexcept {
-        Threadpool.stopThinking();
+        Threadpool().stopThinking();
 
-        TT.clear();
-        TimeMgr.clear();
-        Threadpool.clean();
+        TT().clear();
+        TimeMgr().clear();
+        Threadpool().clean();
 
-        SyzygyTB::initialize(Options["SyzygyPath"]); // Free up mapped files
+        // Free up mapped files, unless other engines share them or the warm-up keeps them mapped
+        if (Engine::count() <= 1
+         && int16_t(Options()["SyzygyWarmup"]) == 0) {
+            SyzygyTB::initialize(Options()["SyzygyPath"]);
+        }
     }
 
 }
 
 uint16_t optionThreads() {
-    uint16_t threadCount{ Options["Threads"] };
+    uint16_t threadCount{ Options()["Threads"] };
     if (threadCount == 0) {
         threadCount = uint16_t(std::thread::hardware_concurrency());
     }
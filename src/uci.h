@@ -4,6 +4,7 @@
 #include <string>
 #include <string_view>
 #include <type_traits>
+#include <vector>
 
 #include "type.h"
 #include "helper/comparer.h"
@@ -53,6 +54,9 @@ namespace UCI {
         const std::string& defaultValue() const noexcept;
         std::string toString() const noexcept;
 
+        void share(std::string&, bool) noexcept;
+        bool locked() const noexcept;
+
         uint32_t    index{ 0 };
 
     private:
@@ -64,12 +68,30 @@ namespace UCI {
                 maxVal{ 0.0 };
 
         OnChange onChange;
+        // Value of the process, if the option is shared by all the engines
+        std::string *sharedVal{ nullptr };
     };
 
 
     /// Options container is std::map of string & Option
     using OptionMap = std::map<std::string, Option, CaseInsensitiveLessComparer>;
 
+    /// Setup records the last position set up by the "position" command of an engine,
+    /// so that a command extending its moves only plays the new ones on the same states.
+    struct Setup {
+
+        void clear() noexcept {
+            fen.clear();
+            moves.clear();
+        }
+
+        std::string fen;
+        std::vector<std::string> moves; // Moves played
+        bool chess960{ false };
+    };
+
+    extern std::string const StartFEN;
+
     extern void initialize() noexcept;
 
     extern void handleCommands(int, char const *const[]);
@@ -80,7 +102,7 @@ namespace UCI {
 extern std::ostream &operator<<(std::ostream &, UCI::Option const &);
 extern std::ostream &operator<<(std::ostream &, UCI::OptionMap const &);
 
-// Global nocase mapping of Options
-extern UCI::OptionMap Options;
+// Nocase mapping of Options of the active engine
+extern UCI::OptionMap& Options() noexcept;
 
 extern uint16_t optionThreads();
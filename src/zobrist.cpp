@@ -1,9 +1,6 @@
 #include "zobrist.h"
 
-#include <cassert>
-
 #include "bitboard.h"
-#include "helper/prng.h"
 
 /// Zobrist::computeMatlKey() computes hash key of the material situation.
 Key Zobrist::computeMatlKey(Position const &pos) const noexcept {
@@ -45,43 +42,8 @@ Key Zobrist::computePosiKey(Position const &pos) const noexcept {
     return posiKey;
 }
 
-namespace Zobrists {
-
-    /// initialize() initializes Zobrist lookup tables.
-    void initialize() noexcept {
-        assert(PolyZob.psq[W_PAWN][SQ_A1] == U64(0x5355F900C2A82DC7));
-        assert(PolyZob.psq[W_KING][SQ_H8] == U64(0xD20D8C88C8FFE65F));
-        assert(PolyZob.psq[B_PAWN][SQ_A1] == U64(0x9D39247E33776D41));
-        assert(PolyZob.psq[B_KING][SQ_H8] == U64(0xFF577222C14F0A3A));
-        assert(PolyZob.side == U64(0xF8D626AAAF278509));
-
-        PRNG prng(0x105524);
-
-        for (Square s = SQ_A1; s <= SQ_H8; ++s) {
-            RandZob.psq[NO_PIECE][s] = 0;
-        }
-        for (Piece p : Pieces) {
-            for (Square s = SQ_A1; s <= SQ_H8; ++s) {
-                RandZob.psq[p][s] = prng.rand<Key>();
-            }
-        }
-        for (File f = FILE_A; f <= FILE_H; ++f) {
-            RandZob.enpassant[f] = prng.rand<Key>();
-        }
-        for (int16_t cr = CR_NONE; cr <= CR_ANY; ++cr) {
-            RandZob.castling[cr] = prng.rand<Key>();
-        }
-        RandZob.side = prng.rand<Key>();
-        RandZob.nopawn = prng.rand<Key>();
-
-    }
-
-}
-
-// Random numbers from PRNG, used to compute position key
-Zobrist RandZob;
 // Constant numbers from Polyglot, used to compute polyglot book key
-Zobrist const PolyZob{
+constexpr Zobrist PolyZob{
     // PieceSquare (768)
     {
         {},
@@ -354,3 +316,9 @@ Zobrist const PolyZob{
     // NoPawn
     U64(0x0000000000000000)
 };
+
+static_assert(PolyZob.psq[W_PAWN][SQ_A1] == U64(0x5355F900C2A82DC7)
+           && PolyZob.psq[W_KING][SQ_H8] == U64(0xD20D8C88C8FFE65F)
+           && PolyZob.psq[B_PAWN][SQ_A1] == U64(0x9D39247E33776D41)
+           && PolyZob.psq[B_KING][SQ_H8] == U64(0xFF577222C14F0A3A)
+           && PolyZob.side == U64(0xF8D626AAAF278509), "Polyglot keys corrupted");
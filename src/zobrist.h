@@ -2,17 +2,11 @@
 
 #include "position.h"
 #include "type.h"
+#include "helper/prng.h"
 
 /// Zobrist class
 struct Zobrist {
 
-    Zobrist() = default;
-    Zobrist(Zobrist const&) = delete;
-    Zobrist(Zobrist&&) = delete;
-
-    Zobrist& operator=(Zobrist const&) = delete;
-    Zobrist& operator=(Zobrist&&) = delete;
-
     Key computeMatlKey(Position const&) const noexcept;
     Key computePawnKey(Position const&) const noexcept;
     Key computePosiKey(Position const&) const noexcept;
@@ -32,8 +26,29 @@ struct Zobrist {
 
 namespace Zobrists {
 
-    extern void initialize() noexcept;
+    /// generate() fills Zobrist keys with random numbers from the given seed.
+    /// It is constexpr so the position keys are baked into the binary at compile time.
+    constexpr Zobrist generate(uint64_t seed) noexcept {
+        Zobrist zob{};
+        PRNG prng(seed);
+
+        for (Piece const p : Pieces) {
+            for (int8_t s = SQ_A1; s <= SQ_H8; ++s) {
+                zob.psq[p][s] = prng.rand<Key>();
+            }
+        }
+        for (int8_t f = FILE_A; f <= FILE_H; ++f) {
+            zob.enpassant[f] = prng.rand<Key>();
+        }
+        for (int16_t cr = CR_NONE; cr <= CR_ANY; ++cr) {
+            zob.castling[cr] = prng.rand<Key>();
+        }
+        zob.side = prng.rand<Key>();
+        zob.nopawn = prng.rand<Key>();
+        return zob;
+    }
 }
 
-extern Zobrist RandZob;
+// Random numbers from PRNG, used to compute position key
+inline constexpr Zobrist RandZob{ Zobrists::generate(0x105524) };
 extern Zobrist const PolyZob;
@@ -14,14 +14,18 @@ echo "reprosearch testing started"
 # repeat two short games, separated by ucinewgame.
 # with go nodes $nodes they should result in exactly
 # the same node count for each iteration.
+# with more threads the deterministic search must give the same.
 cat << EOF > reprosearch.exp
  set timeout 10
  spawn ./DON
- lassign \$argv nodes
+ lassign \$argv nodes threads deterministic
 
  send "uci\n"
  expect "uciok"
 
+ send "setoption name Threads value \$threads\n"
+ send "setoption name Deterministic value \$deterministic\n"
+
  send "ucinewgame\n"
  send "position startpos\n"
  send "go nodes \$nodes\n"
@@ -50,10 +54,18 @@ for i in `seq 1 20`
 do
 
     nodes=$((100*3**i/2**i))
-    echo "reprosearch testing with $nodes nodes"
+    for threads in 1 4
+    do
+
+        echo "reprosearch testing with $nodes nodes and $threads threads"
+
+        # more threads search in deterministic mode
+        deterministic=$([ $threads -gt 1 ] && echo true || echo false)
+
+        # each line should appear exactly an even number of times
+        expect reprosearch.exp $nodes $threads $deterministic 2>&1 | grep -o "nodes [0-9]*" | sort | uniq -c | awk '{if ($1%2!=0) exit(1)}'
 
-    # each line should appear exactly an even number of times
-    expect reprosearch.exp $nodes 2>&1 | grep -o "nodes [0-9]*" | sort | uniq -c | awk '{if ($1%2!=0) exit(1)}'
+    done
 
 done
 